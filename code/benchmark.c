@@ -0,0 +1,665 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <dirent.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// Benchmark harness: runs the solver on a set of CNF files with a per-instance
+// wall-clock timeout and records wall time, CPU time, peak RSS and result.
+
+#define MAX_SOLVER_ARGS 64
+
+typedef enum
+{
+    RES_SAT,
+    RES_UNSAT,
+    RES_TIMEOUT,
+    RES_ERROR
+} BenchResult;
+
+typedef struct
+{
+    char *instance;
+    BenchResult result;
+    int exit_code;
+    double wall;
+    double cpu;
+    long peak_rss_kb;
+    double par2;
+} BenchRun;
+
+typedef struct
+{
+    char *instance;
+    BenchResult result;
+    double wall;
+    double par2;
+} BaselineRun;
+
+typedef struct
+{
+    const char *solver;
+    char *solver_args[MAX_SOLVER_ARGS];
+    int num_solver_args;
+    double timeout;
+    double threshold;
+    double min_delta;
+    const char *output;
+    const char *baseline;
+    const char *label;
+} BenchConfig;
+
+static const char *result_names[] = {"SAT", "UNSAT", "TIMEOUT", "ERROR"};
+
+double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+BenchResult parse_result_name(const char *name)
+{
+    for (int i = 0; i <= RES_ERROR; i++)
+    {
+        size_t len = strlen(result_names[i]);
+        if (strncmp(name, result_names[i], len) == 0 && (name[len] == '\0' || name[len] == ' ' || name[len] == '\n'))
+        {
+            return (BenchResult)i;
+        }
+    }
+
+    return RES_ERROR;
+}
+
+bool is_solved(BenchResult result)
+{
+    return result == RES_SAT || result == RES_UNSAT;
+}
+
+// Extract the "Result: X" line printed by the solver
+BenchResult scan_solver_output(const char *output)
+{
+    const char *line = output;
+    while (line && *line)
+    {
+        if (strncmp(line, "Result: ", 8) == 0)
+        {
+            // A solver stopped by a signal did not solve the instance, but did not fail either
+            if (strncmp(line + 8, "INTERRUPTED", 11) == 0)
+            {
+                return RES_TIMEOUT;
+            }
+            return parse_result_name(line + 8);
+        }
+
+        line = strchr(line, '\n');
+        if (line)
+        {
+            line++;
+        }
+    }
+
+    return RES_ERROR;
+}
+
+void run_instance(const BenchConfig *config, const char *instance, BenchRun *run)
+{
+    run->instance = strdup(instance);
+    run->result = RES_ERROR;
+    run->exit_code = -1;
+    run->wall = 0.0;
+    run->cpu = 0.0;
+    run->peak_rss_kb = 0;
+
+    int pipefd[2];
+    if (pipe(pipefd) != 0)
+    {
+        perror("pipe");
+        return;
+    }
+
+    double start = now_seconds();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        close(pipefd[0]);
+        close(pipefd[1]);
+        return;
+    }
+
+    if (pid == 0)
+    {
+        // Child: own process group so the whole solver tree can be killed on timeout
+        setpgid(0, 0);
+        dup2(pipefd[1], STDOUT_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0)
+        {
+            dup2(devnull, STDERR_FILENO);
+            close(devnull);
+        }
+        close(pipefd[0]);
+        close(pipefd[1]);
+
+        char *argv[MAX_SOLVER_ARGS + 3];
+        int argc = 0;
+        argv[argc++] = (char *)config->solver;
+        for (int i = 0; i < config->num_solver_args; i++)
+        {
+            argv[argc++] = config->solver_args[i];
+        }
+        argv[argc++] = (char *)instance;
+        argv[argc] = NULL;
+
+        execv(config->solver, argv);
+        _exit(127);
+    }
+
+    close(pipefd[1]);
+    setpgid(pid, pid);
+
+    size_t cap = 4096, len = 0;
+    char *output = malloc(cap);
+    bool timed_out = false;
+
+    while (true)
+    {
+        double remaining = config->timeout - (now_seconds() - start);
+        if (remaining <= 0)
+        {
+            timed_out = true;
+            break;
+        }
+
+        struct pollfd pfd = {pipefd[0], POLLIN, 0};
+        int wait_ms = remaining > 1.0 ? 1000 : (int)(remaining * 1000) + 1;
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (ready == 0)
+        {
+            continue;
+        }
+
+        if (len + 1024 >= cap)
+        {
+            cap *= 2;
+            output = realloc(output, cap);
+        }
+
+        ssize_t n = read(pipefd[0], output + len, cap - len - 1);
+        if (n <= 0)
+        {
+            break; // EOF: solver closed stdout
+        }
+        len += n;
+    }
+    output[len] = '\0';
+    close(pipefd[0]);
+
+    if (timed_out)
+    {
+        kill(-pid, SIGKILL);
+        kill(pid, SIGKILL);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR)
+    {
+    }
+
+    run->wall = now_seconds() - start;
+    run->cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    run->peak_rss_kb = usage.ru_maxrss;
+
+    if (timed_out)
+    {
+        run->result = RES_TIMEOUT;
+        run->wall = config->timeout;
+    }
+    else if (WIFEXITED(status))
+    {
+        run->exit_code = WEXITSTATUS(status);
+        run->result = scan_solver_output(output);
+    }
+    else if (WIFSIGNALED(status))
+    {
+        run->exit_code = 128 + WTERMSIG(status);
+    }
+
+    free(output);
+}
+
+// PAR-2: solved instances count their wall time, unsolved ones twice the timeout
+double par2_score(BenchResult result, double wall, double timeout)
+{
+    return is_solved(result) ? wall : 2.0 * timeout;
+}
+
+bool has_cnf_suffix(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 4 && strcmp(name + len - 4, ".cnf") == 0;
+}
+
+int filter_cnf(const struct dirent *entry)
+{
+    return entry->d_name[0] != '.' && has_cnf_suffix(entry->d_name);
+}
+
+// Collect instances from a file or a directory of *.cnf files, sorted by name
+void collect_instances(const char *path, char ***instances, int *count, int *capacity)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        fprintf(stderr, "Cannot access %s\n", path);
+        return;
+    }
+
+    if (S_ISDIR(st.st_mode))
+    {
+        struct dirent **entries;
+        int n = scandir(path, &entries, filter_cnf, alphasort);
+        for (int i = 0; i < n; i++)
+        {
+            char *full = NULL;
+            if (asprintf(&full, "%s/%s", path, entries[i]->d_name) >= 0)
+            {
+                collect_instances(full, instances, count, capacity);
+                free(full);
+            }
+            free(entries[i]);
+        }
+        if (n >= 0)
+        {
+            free(entries);
+        }
+        return;
+    }
+
+    if (*count >= *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 64;
+        *instances = realloc(*instances, sizeof(char *) * *capacity);
+    }
+    (*instances)[(*count)++] = strdup(path);
+}
+
+// Find the column index of a header field in a CSV header line
+int csv_column(char *header, const char *name)
+{
+    int column = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(header, ",\n\r", &save); tok != NULL; tok = strtok_r(NULL, ",\n\r", &save))
+    {
+        if (strcmp(tok, name) == 0)
+        {
+            return column;
+        }
+        column++;
+    }
+
+    return -1;
+}
+
+BaselineRun *load_baseline(const char *filename, int *count, double timeout)
+{
+    FILE *file = fopen(filename, "r");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    char *line = NULL;
+    size_t len = 0;
+    if (getline(&line, &len, file) == -1)
+    {
+        free(line);
+        fclose(file);
+        return NULL;
+    }
+
+    char *header = strdup(line);
+    int col_instance = csv_column(strcpy(header, line), "instance");
+    int col_result = csv_column(strcpy(header, line), "result");
+    int col_wall = csv_column(strcpy(header, line), "wall_s");
+    int col_par2 = csv_column(strcpy(header, line), "par2");
+    free(header);
+
+    if (col_instance < 0 || col_result < 0 || col_wall < 0)
+    {
+        fprintf(stderr, "Baseline %s lacks instance/result/wall_s columns\n", filename);
+        free(line);
+        fclose(file);
+        return NULL;
+    }
+
+    int capacity = 64;
+    BaselineRun *runs = malloc(sizeof(BaselineRun) * capacity);
+    *count = 0;
+
+    while (getline(&line, &len, file) != -1)
+    {
+        if (line[0] == '#' || strlen(line) < 2)
+            continue;
+
+        BaselineRun run = {NULL, RES_ERROR, 0.0, -1.0};
+        int column = 0;
+        char *save = NULL;
+        for (char *tok = strtok_r(line, ",\n\r", &save); tok != NULL; tok = strtok_r(NULL, ",\n\r", &save))
+        {
+            if (column == col_instance)
+                run.instance = strdup(tok);
+            else if (column == col_result)
+                run.result = parse_result_name(tok);
+            else if (column == col_wall)
+                run.wall = atof(tok);
+            else if (column == col_par2)
+                run.par2 = atof(tok);
+            column++;
+        }
+
+        if (!run.instance)
+            continue;
+
+        if (run.par2 < 0)
+        {
+            run.par2 = par2_score(run.result, run.wall, timeout);
+        }
+
+        if (*count >= capacity)
+        {
+            capacity *= 2;
+            runs = realloc(runs, sizeof(BaselineRun) * capacity);
+        }
+        runs[(*count)++] = run;
+    }
+
+    free(line);
+    fclose(file);
+    return runs;
+}
+
+BaselineRun *find_baseline(BaselineRun *baseline, int count, const char *instance)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(baseline[i].instance, instance) == 0)
+        {
+            return &baseline[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Compare every run against the baseline, returns the number of regressions
+int compare_baseline(const BenchConfig *config, BenchRun *runs, int count, BaselineRun *baseline, int baseline_count)
+{
+    int regressions = 0, improvements = 0, matched = 0;
+    double par2_new = 0.0, par2_old = 0.0;
+
+    for (int i = 0; i < count; i++)
+    {
+        BaselineRun *base = find_baseline(baseline, baseline_count, runs[i].instance);
+        if (!base)
+        {
+            continue;
+        }
+
+        matched++;
+        par2_new += runs[i].par2;
+        par2_old += base->par2;
+
+        if (is_solved(runs[i].result) && is_solved(base->result) && runs[i].result != base->result)
+        {
+            printf("WRONG      %s: %s (baseline %s)\n", runs[i].instance, result_names[runs[i].result], result_names[base->result]);
+            regressions++;
+        }
+        else if (!is_solved(runs[i].result) && is_solved(base->result))
+        {
+            printf("REGRESSION %s: %s (baseline %s in %.3fs)\n", runs[i].instance, result_names[runs[i].result], result_names[base->result], base->wall);
+            regressions++;
+        }
+        else if (is_solved(runs[i].result))
+        {
+            double delta = runs[i].wall - base->wall;
+            if (delta > config->min_delta && runs[i].wall > base->wall * (1.0 + config->threshold))
+            {
+                printf("REGRESSION %s: %.3fs (baseline %.3fs, %+.1f%%)\n", runs[i].instance, runs[i].wall, base->wall, 100.0 * delta / base->wall);
+                regressions++;
+            }
+            else if (-delta > config->min_delta && base->wall > runs[i].wall * (1.0 + config->threshold))
+            {
+                improvements++;
+            }
+        }
+    }
+
+    if (matched > 0)
+    {
+        printf("Baseline: %d matched | PAR-2 %.3f -> %.3f (%+.1f%%) | %d regressions | %d improvements\n",
+               matched, par2_old / matched, par2_new / matched,
+               par2_old > 0 ? 100.0 * (par2_new - par2_old) / par2_old : 0.0, regressions, improvements);
+    }
+    else
+    {
+        printf("Baseline: no matching instances\n");
+    }
+
+    return regressions;
+}
+
+void write_csv(const BenchConfig *config, BenchRun *runs, int count)
+{
+    FILE *out = stdout;
+    if (config->output && strcmp(config->output, "-") != 0)
+    {
+        out = fopen(config->output, "w");
+        if (!out)
+        {
+            perror(config->output);
+            return;
+        }
+    }
+
+    fprintf(out, "instance,config,result,exit_code,wall_s,cpu_s,peak_rss_kb,par2\n");
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(out, "%s,%s,%s,%d,%.6f,%.6f,%ld,%.6f\n", runs[i].instance, config->label,
+                result_names[runs[i].result], runs[i].exit_code, runs[i].wall, runs[i].cpu,
+                runs[i].peak_rss_kb, runs[i].par2);
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+}
+
+// Split the --args string on whitespace into separate solver arguments
+void split_solver_args(BenchConfig *config, char *args)
+{
+    char *save = NULL;
+    for (char *tok = strtok_r(args, " \t", &save); tok != NULL; tok = strtok_r(NULL, " \t", &save))
+    {
+        if (config->num_solver_args < MAX_SOLVER_ARGS)
+        {
+            config->solver_args[config->num_solver_args++] = tok;
+        }
+    }
+}
+
+void print_usage(const char *prog)
+{
+    printf("Usage: %s [options] <dir|file.cnf>...\n", prog);
+    printf("  -s, --solver PATH      Solver binary (default ./sat_solver)\n");
+    printf("  -a, --args ARGS        Extra arguments passed to the solver\n");
+    printf("  -t, --timeout SEC      Per-instance wall-clock timeout (default 3600)\n");
+    printf("  -o, --output FILE      Write per-instance CSV to FILE ('-' for stdout)\n");
+    printf("  -b, --baseline FILE    Compare against a previous CSV and flag regressions\n");
+    printf("  -r, --threshold PCT    Slowdown treated as regression (default 10)\n");
+    printf("  -m, --min-delta SEC    Ignore differences below this many seconds (default 0.05)\n");
+    printf("  -l, --label NAME       Configuration label written to the CSV (default default)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig config = {"./sat_solver", {NULL}, 0, 3600.0, 0.10, 0.05, NULL, NULL, "default"};
+
+    static struct option long_options[] = {
+        {"solver", required_argument, 0, 's'},
+        {"args", required_argument, 0, 'a'},
+        {"timeout", required_argument, 0, 't'},
+        {"output", required_argument, 0, 'o'},
+        {"baseline", required_argument, 0, 'b'},
+        {"threshold", required_argument, 0, 'r'},
+        {"min-delta", required_argument, 0, 'm'},
+        {"label", required_argument, 0, 'l'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:a:t:o:b:r:m:l:h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            config.solver = optarg;
+            break;
+        case 'a':
+            split_solver_args(&config, optarg);
+            break;
+        case 't':
+            config.timeout = atof(optarg);
+            break;
+        case 'o':
+            config.output = optarg;
+            break;
+        case 'b':
+            config.baseline = optarg;
+            break;
+        case 'r':
+            config.threshold = atof(optarg) / 100.0;
+            break;
+        case 'm':
+            config.min_delta = atof(optarg);
+            break;
+        case 'l':
+            config.label = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind >= argc || config.timeout <= 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (access(config.solver, X_OK) != 0)
+    {
+        fprintf(stderr, "Solver %s is not executable (run make first)\n", config.solver);
+        return 1;
+    }
+
+    char **instances = NULL;
+    int count = 0, capacity = 0;
+    for (int i = optind; i < argc; i++)
+    {
+        collect_instances(argv[i], &instances, &count, &capacity);
+    }
+
+    if (count == 0)
+    {
+        fprintf(stderr, "No .cnf instances found\n");
+        return 1;
+    }
+
+    BenchRun *runs = calloc(count, sizeof(BenchRun));
+    int solved = 0, num_sat = 0, num_unsat = 0, num_timeout = 0, num_error = 0;
+    double par2_total = 0.0, cpu_total = 0.0;
+
+    for (int i = 0; i < count; i++)
+    {
+        run_instance(&config, instances[i], &runs[i]);
+        runs[i].par2 = par2_score(runs[i].result, runs[i].wall, config.timeout);
+
+        fprintf(stderr, "[%d/%d] %-40s %-7s %10.3fs %10.3fs %8ld KB\n", i + 1, count, instances[i],
+                result_names[runs[i].result], runs[i].wall, runs[i].cpu, runs[i].peak_rss_kb);
+
+        par2_total += runs[i].par2;
+        cpu_total += runs[i].cpu;
+        solved += is_solved(runs[i].result);
+        num_sat += runs[i].result == RES_SAT;
+        num_unsat += runs[i].result == RES_UNSAT;
+        num_timeout += runs[i].result == RES_TIMEOUT;
+        num_error += runs[i].result == RES_ERROR;
+    }
+
+    if (config.output)
+    {
+        write_csv(&config, runs, count);
+    }
+
+    printf("Instances: %d | Solved: %d (SAT %d, UNSAT %d) | Timeout: %d | Error: %d\n",
+           count, solved, num_sat, num_unsat, num_timeout, num_error);
+    printf("PAR-2: %.3f | Total CPU time: %.3f seconds\n", par2_total / count, cpu_total);
+
+    int regressions = 0;
+    if (config.baseline)
+    {
+        int baseline_count = 0;
+        BaselineRun *baseline = load_baseline(config.baseline, &baseline_count, config.timeout);
+        if (!baseline)
+        {
+            fprintf(stderr, "Failed to load baseline %s\n", config.baseline);
+            regressions = 1;
+        }
+        else
+        {
+            regressions = compare_baseline(&config, runs, count, baseline, baseline_count);
+            for (int i = 0; i < baseline_count; i++)
+            {
+                free(baseline[i].instance);
+            }
+            free(baseline);
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        free(runs[i].instance);
+        free(instances[i]);
+    }
+    free(runs);
+    free(instances);
+
+    // Non-zero exit when anything regressed or failed, so scripts can gate on it
+    return (regressions > 0 || num_error > 0) ? 2 : 0;
+}
@@ -0,0 +1,910 @@
+// Differential fuzzer: solves small random CNFs and checks the answer against a
+// brute-force enumerator, verifies SAT models against the original clauses and
+// checks that backtracking restores the undo-stack state exactly and that a
+// search resumed from its guiding path gives the same answer, that the
+// word-sized search of --batch agrees, that a lucky phase reported as a model is
+// one, that every BVA application removes more clauses than it adds, and that
+// the cache hash ignores clause and literal order and duplicates. Failing inputs
+// are shrunk by deleting clauses and literals and written as DIMACS.
+#define SAT_SOLVER_NO_MAIN
+#include "sat_solver.c"
+#include "rng.h"
+
+typedef struct
+{
+    long iterations;
+    uint64_t seed;
+    int max_vars;
+    int max_clauses;
+    int max_clause_size;
+    const char *out_dir;
+    bool verbose;
+    bool grids; // Plant clause grids for BVA to find
+    bool gates; // Plant gate definitions for BVE to find
+} FuzzOptions;
+
+typedef enum
+{
+    FUZZ_OK,
+    FUZZ_WRONG_ANSWER,
+    FUZZ_BAD_MODEL,
+    FUZZ_BROKEN_UNDO,
+    FUZZ_WRONG_BACKBONE,
+    FUZZ_HASH_MISMATCH,
+    FUZZ_BAD_RESUME,
+    FUZZ_BAD_BATCH,
+    FUZZ_BVA_NO_GAIN,
+    FUZZ_BAD_LUCKY,
+    FUZZ_TIMEOUT
+} FuzzOutcome;
+
+static const char *outcome_names[] = {"ok", "wrong answer", "invalid model", "undo invariant broken", "wrong backbone",
+                                      "hash mismatch", "wrong answer after resume", "wrong answer in batch mode",
+                                      "BVA application without clause reduction", "wrong model from lucky phases",
+                                      "timeout"};
+
+// Lucky-phase checks that found a model
+static long lucky_solved = 0;
+// And those that a simulated lane made unnecessary
+static long simulation_solved = 0;
+
+// Plain clause list used for generation, shrinking and brute force, kept
+// independent of the solver's data structures
+typedef struct
+{
+    int numVars;
+    int numClauses;
+    int *sizes;
+    int **lits; // DIMACS literals
+} Cnf;
+
+// Random literal over the variables of cnf
+int random_literal(Rng *rng, const Cnf *cnf)
+{
+    int var = 1 + rng_below(rng, cnf->numVars);
+    return (rng_next(rng) & 1) ? -var : var;
+}
+
+// Tseitin clauses of a random AND, XOR or ITE gate over distinct variables,
+// written to clauses[0..]; returns their number
+int plant_gate(Rng *rng, const Cnf *cnf, int clauses[4][4], int *sizes)
+{
+    int vars[4], count = 0;
+    while (count < 4)
+    {
+        int var = 1 + rng_below(rng, cnf->numVars);
+        bool fresh = true;
+        for (int i = 0; i < count; i++)
+        {
+            fresh &= vars[i] != var;
+        }
+        if (fresh)
+        {
+            vars[count++] = (rng_next(rng) & 1) ? -var : var;
+        }
+    }
+
+    int o = vars[0], a = vars[1], b = vars[2], c = vars[3];
+    int type = rng_below(rng, NUM_GATE_TYPES);
+    if (type == GATE_AND)
+    {
+        int and[3][3] = {{-o, a}, {-o, b}, {o, -a, -b}};
+        int andSizes[3] = {2, 2, 3};
+        for (int i = 0; i < 3; i++)
+        {
+            sizes[i] = andSizes[i];
+            memcpy(clauses[i], and[i], sizeof(int) * andSizes[i]);
+        }
+        return 3;
+    }
+
+    int xor[4][3] = {{-o, a, b}, {-o, -a, -b}, {o, -a, b}, {o, a, -b}};
+    int ite[4][3] = {{-o, -a, b}, {-o, a, c}, {o, -a, -b}, {o, a, -c}};
+    for (int i = 0; i < 4; i++)
+    {
+        sizes[i] = 3;
+        memcpy(clauses[i], type == GATE_XOR ? xor[i] : ite[i], sizeof(int) * 3);
+    }
+    return 4;
+}
+
+// With grids, half of the formulas end in a grid (L_i | C_j) of 2-4 literals
+// L_i and 2-4 clause rests C_j of one or two literals, which BVA can factor.
+// With gates, half of the formulas with at least four variables also define one
+// or two of them by a gate.
+Cnf *cnf_random(Rng *rng, const FuzzOptions *options)
+{
+    Cnf *cnf = malloc(sizeof(Cnf));
+    cnf->numVars = 1 + rng_below(rng, options->max_vars);
+    int numRandom = 1 + rng_below(rng, options->max_clauses);
+    int gridLits = 0, gridRests = 0;
+    if (options->grids && (rng_next(rng) & 1))
+    {
+        gridLits = 2 + rng_below(rng, 3);
+        gridRests = 2 + rng_below(rng, 3);
+    }
+    int gateClauses[8][4], gateSizes[8], numGate = 0;
+    if (options->gates && cnf->numVars >= 4 && (rng_next(rng) & 1))
+    {
+        int numGates = 1 + rng_below(rng, 2);
+        for (int g = 0; g < numGates; g++)
+        {
+            numGate += plant_gate(rng, cnf, &gateClauses[numGate], &gateSizes[numGate]);
+        }
+    }
+    cnf->numClauses = numRandom + gridLits * gridRests + numGate;
+    cnf->sizes = malloc(sizeof(int) * cnf->numClauses);
+    cnf->lits = malloc(sizeof(int *) * cnf->numClauses);
+
+    int lits[4], rests[4][2], restSize[4];
+    for (int i = 0; i < gridLits; i++)
+    {
+        lits[i] = random_literal(rng, cnf);
+    }
+    for (int j = 0; j < gridRests; j++)
+    {
+        restSize[j] = 1 + rng_below(rng, 2);
+        for (int k = 0; k < restSize[j]; k++)
+        {
+            rests[j][k] = random_literal(rng, cnf);
+        }
+    }
+    for (int i = 0; i < gridLits; i++)
+    {
+        for (int j = 0; j < gridRests; j++)
+        {
+            int index = numRandom + i * gridRests + j;
+            cnf->sizes[index] = 1 + restSize[j];
+            cnf->lits[index] = malloc(sizeof(int) * (1 + restSize[j]));
+            cnf->lits[index][0] = lits[i];
+            memcpy(&cnf->lits[index][1], rests[j], sizeof(int) * restSize[j]);
+        }
+    }
+
+    for (int i = 0; i < numGate; i++)
+    {
+        int index = numRandom + gridLits * gridRests + i;
+        cnf->sizes[index] = gateSizes[i];
+        cnf->lits[index] = malloc(sizeof(int) * gateSizes[i]);
+        memcpy(cnf->lits[index], gateClauses[i], sizeof(int) * gateSizes[i]);
+    }
+
+    for (int i = 0; i < numRandom; i++)
+    {
+        // Mostly short clauses; duplicates and tautologies are allowed on purpose
+        int size = 1 + rng_below(rng, options->max_clause_size);
+        cnf->sizes[i] = size;
+        cnf->lits[i] = malloc(sizeof(int) * size);
+        for (int j = 0; j < size; j++)
+        {
+            cnf->lits[i][j] = random_literal(rng, cnf);
+        }
+    }
+
+    return cnf;
+}
+
+Cnf *cnf_copy(const Cnf *src)
+{
+    Cnf *cnf = malloc(sizeof(Cnf));
+    cnf->numVars = src->numVars;
+    cnf->numClauses = src->numClauses;
+    cnf->sizes = malloc(sizeof(int) * src->numClauses);
+    cnf->lits = malloc(sizeof(int *) * src->numClauses);
+    for (int i = 0; i < src->numClauses; i++)
+    {
+        cnf->sizes[i] = src->sizes[i];
+        cnf->lits[i] = malloc(sizeof(int) * src->sizes[i]);
+        memcpy(cnf->lits[i], src->lits[i], sizeof(int) * src->sizes[i]);
+    }
+    return cnf;
+}
+
+void cnf_free(Cnf *cnf)
+{
+    for (int i = 0; i < cnf->numClauses; i++)
+    {
+        free(cnf->lits[i]);
+    }
+    free(cnf->sizes);
+    free(cnf->lits);
+    free(cnf);
+}
+
+void cnf_remove_clause(Cnf *cnf, int index)
+{
+    free(cnf->lits[index]);
+    for (int i = index; i < cnf->numClauses - 1; i++)
+    {
+        cnf->sizes[i] = cnf->sizes[i + 1];
+        cnf->lits[i] = cnf->lits[i + 1];
+    }
+    cnf->numClauses--;
+}
+
+void cnf_remove_literal(Cnf *cnf, int clause, int index)
+{
+    for (int j = index; j < cnf->sizes[clause] - 1; j++)
+    {
+        cnf->lits[clause][j] = cnf->lits[clause][j + 1];
+    }
+    cnf->sizes[clause]--;
+}
+
+void cnf_write(FILE *out, const Cnf *cnf)
+{
+    fprintf(out, "p cnf %d %d\n", cnf->numVars, cnf->numClauses);
+    for (int i = 0; i < cnf->numClauses; i++)
+    {
+        for (int j = 0; j < cnf->sizes[i]; j++)
+        {
+            fprintf(out, "%d ", cnf->lits[i][j]);
+        }
+        fprintf(out, "0\n");
+    }
+}
+
+bool cnf_satisfied_by(const Cnf *cnf, const int *value)
+{
+    for (int i = 0; i < cnf->numClauses; i++)
+    {
+        bool sat = false;
+        for (int j = 0; j < cnf->sizes[i] && !sat; j++)
+        {
+            int lit = cnf->lits[i][j];
+            sat = lit > 0 ? value[lit] == 1 : value[-lit] == 0;
+        }
+        if (!sat)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Enumerate all 2^n assignments
+bool brute_force_sat(const Cnf *cnf)
+{
+    int *value = calloc(cnf->numVars + 1, sizeof(int));
+    bool found = false;
+    for (unsigned long bits = 0; bits < (1ul << cnf->numVars) && !found; bits++)
+    {
+        for (int v = 1; v <= cnf->numVars; v++)
+        {
+            value[v] = (bits >> (v - 1)) & 1;
+        }
+        found = cnf_satisfied_by(cnf, value);
+    }
+    free(value);
+    return found;
+}
+
+// Backbone by enumeration: value[v] is 1 or 0 if every model agrees on v, -1 if
+// models differ
+void brute_force_backbone(const Cnf *cnf, int *value)
+{
+    int *assignment = calloc(cnf->numVars + 1, sizeof(int));
+    bool *seen[2] = {calloc(cnf->numVars + 1, sizeof(bool)), calloc(cnf->numVars + 1, sizeof(bool))};
+    for (unsigned long bits = 0; bits < (1ul << cnf->numVars); bits++)
+    {
+        for (int v = 1; v <= cnf->numVars; v++)
+        {
+            assignment[v] = (bits >> (v - 1)) & 1;
+        }
+        if (cnf_satisfied_by(cnf, assignment))
+        {
+            for (int v = 1; v <= cnf->numVars; v++)
+            {
+                seen[assignment[v]][v] = true;
+            }
+        }
+    }
+    for (int v = 1; v <= cnf->numVars; v++)
+    {
+        value[v] = seen[0][v] == seen[1][v] ? -1 : seen[1][v];
+    }
+    free(seen[0]);
+    free(seen[1]);
+    free(assignment);
+}
+
+Formula *cnf_to_formula(const Cnf *cnf)
+{
+    Formula *formula = malloc(sizeof(Formula));
+    formula->numVars = cnf->numVars;
+    formula->numClauses = cnf->numClauses;
+    formula->clauses = malloc(sizeof(Clause) * (cnf->numClauses > 0 ? cnf->numClauses : 1));
+    for (int i = 0; i < cnf->numClauses; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        clause->size = cnf->sizes[i];
+        clause->satisfied = false;
+        clause->literals = malloc(sizeof(Literal) * (cnf->sizes[i] > 0 ? cnf->sizes[i] : 1));
+        for (int j = 0; j < cnf->sizes[i]; j++)
+        {
+            clause->literals[j].var = abs(cnf->lits[i][j]);
+            clause->literals[j].neg = cnf->lits[i][j] < 0;
+        }
+        remove_duplicate_literals(clause);
+    }
+    return formula;
+}
+
+// Sorted copy of every watch list, watch lists are multisets after undo
+int **snapshot_watches(WatchTable *wtable)
+{
+    int **snapshot = malloc(sizeof(int *) * wtable->numVars);
+    for (int i = 0; i < wtable->numVars; i++)
+    {
+        GArray *arr = wtable->watch_lists[i];
+        snapshot[i] = malloc(sizeof(int) * (arr->len + 1));
+        snapshot[i][0] = arr->len;
+        memcpy(snapshot[i] + 1, arr->data, sizeof(int) * arr->len);
+        qsort(snapshot[i] + 1, arr->len, sizeof(int), compare_int);
+    }
+    return snapshot;
+}
+
+void free_snapshot(int **snapshot, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        free(snapshot[i]);
+    }
+    free(snapshot);
+}
+
+// After unwinding to an empty stack the state must equal the initial state
+bool state_restored(Formula *formula, int *assignments, WatchTable *wtable, int **initial)
+{
+    if (trail_size != 0)
+        return false;
+
+    for (int v = 1; v <= formula->numVars; v++)
+    {
+        if (assignments[v] != -1)
+            return false;
+    }
+
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (formula->clauses[i].satisfied)
+            return false;
+    }
+
+    int **now = snapshot_watches(wtable);
+    bool same = true;
+    for (int i = 0; i < wtable->numVars && same; i++)
+    {
+        same = now[i][0] == initial[i][0] && memcmp(now[i] + 1, initial[i] + 1, sizeof(int) * now[i][0]) == 0;
+    }
+    free_snapshot(now, wtable->numVars);
+    return same;
+}
+
+void reset_search_state()
+{
+    memset(&stats, 0, sizeof(stats));
+    limits.decisions = 0;
+    limit_reached = LIMIT_NONE;
+    clock_check_countdown = 0;
+    trail_size = 0;
+    search_depth = 0;
+    symmetry.steps = 0;
+    bva.steps = 0;
+    bva.exhausted = false;
+    bva.least_gain = INT_MAX;
+    probing.steps = 0;
+    probing.exhausted = false;
+    elimination.steps = 0;
+    elimination.exhausted = false;
+    checkpointing.mismatch = false;
+}
+
+// Run the same pipeline as main under an optional decision limit. Returns the
+// dpll result and checks the undo invariant after unwinding everything. An
+// interrupted search leaves its guiding path in checkpointing for a resume.
+// Lucky phases would answer most satisfiable formulas before the search, so they
+// only run with lucky_only, instead of simulation and the search: the result is
+// SAT if a phase is a model and TIMEOUT otherwise.
+DPLLReturnType fuzz_solve(const Cnf *cnf, unsigned long long decision_limit, bool lucky_only, int *model,
+                          bool *undo_ok)
+{
+    reset_search_state();
+    limits.decisions = decision_limit;
+
+    Formula *formula = cnf_to_formula(cnf);
+    remove_supersets(formula);
+    if (probing.enabled)
+    {
+        probe_failed_literals(formula);
+    }
+    if (elimination.enabled)
+    {
+        eliminate_variables(formula);
+    }
+    if (bva.enabled)
+    {
+        bounded_variable_addition(formula);
+    }
+    var_sort = decision_order(formula);
+    defer_defined_variables(var_sort, formula->numVars, cnf->numVars);
+    if (symmetry.enabled)
+    {
+        int numVarsBefore = formula->numVars;
+        add_symmetry_breaking(formula, var_sort);
+        var_sort = append_variables(var_sort, numVarsBefore, formula->numVars);
+    }
+    WatchTable *wtable = build_watch_table(formula);
+    int **initial = snapshot_watches(wtable);
+
+    int *assignments = malloc(sizeof(int) * (formula->numVars + 1));
+    for (int i = 0; i <= formula->numVars; i++)
+    {
+        assignments[i] = -1;
+    }
+    branch_state = calloc(formula->numVars + 2, sizeof(unsigned char));
+    decision_path = calloc(formula->numVars + 2, sizeof(int));
+    UndoStack stack = {NULL};
+
+    bool presolved = false;
+    if (lucky_only)
+    {
+        presolved = lucky_phases(formula, assignments, &stack);
+        lucky_solved += presolved;
+    }
+    else if (simulation.enabled)
+    {
+        presolved = simulate_assignments(formula, assignments, &stack);
+        simulation_solved += presolved;
+        // Every other simulated model is dropped, so that satisfiable formulas
+        // are also searched with the phases set
+        if (presolved && (simulation.seed & 1))
+        {
+            undo_to_checkpoint(&stack, NULL, formula, assignments, wtable);
+            presolved = false;
+        }
+    }
+    checkpointing.active = true;
+    DPLLReturnType result = presolved ? SAT : lucky_only ? TIMEOUT : dpll(formula, assignments, &stack, wtable, 0);
+    checkpointing.active = false;
+    if (result == TIMEOUT && !lucky_only)
+    {
+        checkpoint_capture();
+        checkpointing.replaying = false;
+    }
+    if (result == SAT)
+    {
+        // Eliminated variables are set in the copy, assignments must unwind as assigned
+        memcpy(model, assignments, sizeof(int) * (cnf->numVars + 1));
+        reconstruct_model(model);
+        // An interrupted backbone never matches the expected one
+        if (backbone.enabled)
+        {
+            if (compute_backbone(formula, assignments, &stack, wtable, cnf->numVars) == TIMEOUT)
+            {
+                backbone.size = -1;
+            }
+        }
+    }
+
+    undo_to_checkpoint(&stack, NULL, formula, assignments, wtable);
+    *undo_ok = state_restored(formula, assignments, wtable, initial);
+
+    free_snapshot(initial, wtable->numVars);
+    free(branch_state);
+    branch_state = NULL;
+    free(decision_path);
+    decision_path = NULL;
+    free(decision_phase);
+    decision_phase = NULL;
+    free(var_sort);
+    var_sort = NULL;
+    free(assignments);
+    free_watchtable(wtable);
+    free_formula(formula);
+    free_elimination();
+    return result;
+}
+
+// The same clause set reordered: clauses reversed, literals rotated, the first
+// clause repeated and a tautology added. Must hash like the original.
+bool hash_invariant(const Cnf *cnf)
+{
+    Cnf *copy = malloc(sizeof(Cnf));
+    copy->numVars = cnf->numVars;
+    int n = cnf->numClauses;
+    copy->numClauses = n + (n > 0) + 1;
+    copy->sizes = malloc(sizeof(int) * copy->numClauses);
+    copy->lits = malloc(sizeof(int *) * copy->numClauses);
+    for (int i = 0; i < cnf->numClauses; i++)
+    {
+        int src = cnf->numClauses - 1 - i, size = cnf->sizes[src];
+        copy->sizes[i] = size;
+        copy->lits[i] = malloc(sizeof(int) * (size > 0 ? size : 1));
+        for (int j = 0; j < size; j++)
+        {
+            copy->lits[i][j] = cnf->lits[src][(j + 1) % size];
+        }
+    }
+    if (n > 0)
+    {
+        copy->sizes[n] = cnf->sizes[0];
+        copy->lits[n] = malloc(sizeof(int) * (cnf->sizes[0] > 0 ? cnf->sizes[0] : 1));
+        memcpy(copy->lits[n], cnf->lits[0], sizeof(int) * cnf->sizes[0]);
+    }
+    int last = copy->numClauses - 1;
+    copy->sizes[last] = 2;
+    copy->lits[last] = malloc(sizeof(int) * 2);
+    copy->lits[last][0] = 1;
+    copy->lits[last][1] = -1;
+
+    char key[sizeof(cache.key)];
+    Formula *formula = cnf_to_formula(cnf);
+    formula_hash(formula);
+    memcpy(key, cache.key, sizeof(key));
+    free_formula(formula);
+    formula = cnf_to_formula(copy);
+    formula_hash(formula);
+    free_formula(formula);
+    cnf_free(copy);
+    return strcmp(key, cache.key) == 0;
+}
+
+// Unassigned variables may take any value; check them as false
+bool model_satisfies(const Cnf *cnf, int *model)
+{
+    for (int v = 1; v <= cnf->numVars; v++)
+    {
+        if (model[v] == -1)
+            model[v] = 0;
+    }
+    return cnf_satisfied_by(cnf, model);
+}
+
+// The word-sized search of --batch finds the expected answer and a model
+bool batch_agrees(const Cnf *cnf, bool expected, int *model)
+{
+    WordFormula formula = {0, 0, 0, NULL, false, 0, {0}, 0};
+    for (int i = 0; i < cnf->numClauses; i++)
+    {
+        word_add_clause(&formula, cnf->lits[i], cnf->sizes[i]);
+    }
+    limits.decisions = 0;
+    limit_reached = LIMIT_NONE;
+    uint64_t word_model = 0;
+    DPLLReturnType result = word_solve(&formula, &word_model);
+    free(formula.clauses);
+
+    for (int v = 1; v <= cnf->numVars; v++)
+    {
+        model[v] = (word_model >> (v - 1)) & 1;
+    }
+    return result != TIMEOUT && (result == SAT) == expected && (result != SAT || cnf_satisfied_by(cnf, model));
+}
+
+FuzzOutcome check_cnf(const Cnf *cnf)
+{
+    bool expected = brute_force_sat(cnf);
+    int *model = malloc(sizeof(int) * (cnf->numVars + 1));
+    bool undo_ok = true;
+
+    DPLLReturnType result = fuzz_solve(cnf, 0, false, model, &undo_ok);
+    FuzzOutcome outcome = FUZZ_OK;
+
+    if (result == TIMEOUT)
+    {
+        outcome = FUZZ_TIMEOUT;
+    }
+    else if ((result == SAT) != expected)
+    {
+        outcome = FUZZ_WRONG_ANSWER;
+    }
+    else if (result == SAT && !model_satisfies(cnf, model))
+    {
+        outcome = FUZZ_BAD_MODEL;
+    }
+
+    if (outcome == FUZZ_OK && result == SAT && backbone.enabled)
+    {
+        int *expected = malloc(sizeof(int) * (cnf->numVars + 1));
+        brute_force_backbone(cnf, expected);
+        int size = 0;
+        for (int v = 1; v <= cnf->numVars; v++)
+        {
+            size += expected[v] != -1;
+        }
+        bool same = backbone.size == size;
+        for (int i = 0; i < backbone.size && same; i++)
+        {
+            int lit = backbone.literals[i];
+            same = expected[abs(lit)] == (lit > 0);
+        }
+        if (!same)
+        {
+            outcome = FUZZ_WRONG_BACKBONE;
+        }
+        free(expected);
+    }
+
+    if (outcome == FUZZ_OK && !undo_ok)
+    {
+        outcome = FUZZ_BROKEN_UNDO;
+    }
+
+    // Every replaced grid must shrink the formula
+    if (outcome == FUZZ_OK && bva.least_gain <= 0)
+    {
+        outcome = FUZZ_BVA_NO_GAIN;
+    }
+
+    // Lucky phases on their own, through preprocessing and model reconstruction
+    if (outcome == FUZZ_OK && lucky.enabled)
+    {
+        DPLLReturnType lucky_result = fuzz_solve(cnf, 0, true, model, &undo_ok);
+        if (lucky_result == SAT && (!expected || !model_satisfies(cnf, model)))
+            outcome = FUZZ_BAD_LUCKY;
+        else if (!undo_ok)
+            outcome = FUZZ_BROKEN_UNDO;
+    }
+
+    if (outcome == FUZZ_OK && !hash_invariant(cnf))
+    {
+        outcome = FUZZ_HASH_MISMATCH;
+    }
+
+    if (outcome == FUZZ_OK && !batch_agrees(cnf, expected, model))
+    {
+        outcome = FUZZ_BAD_BATCH;
+    }
+
+    // Interrupt the search at a few interior points, unwind from there and
+    // resume from the interrupted position
+    for (unsigned long long limit = 1; outcome == FUZZ_OK && limit <= 8; limit *= 2)
+    {
+        DPLLReturnType interrupted = fuzz_solve(cnf, limit, false, model, &undo_ok);
+        if (!undo_ok)
+        {
+            outcome = FUZZ_BROKEN_UNDO;
+        }
+        else if (interrupted == TIMEOUT)
+        {
+            checkpointing.replaying = checkpointing.resume_depth > 0;
+            DPLLReturnType resumed = fuzz_solve(cnf, 0, false, model, &undo_ok);
+            if (checkpointing.mismatch || resumed == TIMEOUT || (resumed == SAT) != expected ||
+                (resumed == SAT && !model_satisfies(cnf, model)))
+                outcome = FUZZ_BAD_RESUME;
+            else if (!undo_ok)
+                outcome = FUZZ_BROKEN_UNDO;
+        }
+    }
+
+    free(model);
+    return outcome;
+}
+
+// Greedy shrinking: drop clauses, then literals, while the same failure remains
+Cnf *shrink(const Cnf *failing, FuzzOutcome outcome)
+{
+    Cnf *best = cnf_copy(failing);
+    bool progress = true;
+    while (progress)
+    {
+        progress = false;
+        for (int i = best->numClauses - 1; i >= 0; i--)
+        {
+            Cnf *candidate = cnf_copy(best);
+            cnf_remove_clause(candidate, i);
+            if (check_cnf(candidate) == outcome)
+            {
+                cnf_free(best);
+                best = candidate;
+                progress = true;
+            }
+            else
+            {
+                cnf_free(candidate);
+            }
+        }
+
+        for (int i = best->numClauses - 1; i >= 0; i--)
+        {
+            for (int j = best->sizes[i] - 1; j >= 0; j--)
+            {
+                if (j >= best->sizes[i])
+                    continue;
+
+                Cnf *candidate = cnf_copy(best);
+                cnf_remove_literal(candidate, i, j);
+                if (check_cnf(candidate) == outcome)
+                {
+                    cnf_free(best);
+                    best = candidate;
+                    progress = true;
+                }
+                else
+                {
+                    cnf_free(candidate);
+                }
+            }
+        }
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    FuzzOptions options = {10000, 1, 10, 40, 4, ".", false, false, false};
+
+    static struct option long_options[] = {
+        {"iterations", required_argument, 0, 'n'},
+        {"seed", required_argument, 0, 's'},
+        {"max-vars", required_argument, 0, 'v'},
+        {"max-clauses", required_argument, 0, 'c'},
+        {"max-size", required_argument, 0, 'k'},
+        {"out-dir", required_argument, 0, 'o'},
+        {"verbose", no_argument, 0, 'V'},
+        {"symmetry", no_argument, 0, 'S'},
+        {"backbone", no_argument, 0, 'b'},
+        {"bva", no_argument, 0, 'B'},
+        {"no-lucky", no_argument, 0, 'L'},
+        {"simulate", no_argument, 0, 'm'},
+        {"probe", no_argument, 0, 'P'},
+        {"bve", no_argument, 0, 'W'},
+        {"heuristic", required_argument, 0, 'E'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:s:v:c:k:o:VSbBLmPWE:h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            options.iterations = atol(optarg);
+            break;
+        case 's':
+            options.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'v':
+            options.max_vars = atoi(optarg);
+            break;
+        case 'c':
+            options.max_clauses = atoi(optarg);
+            break;
+        case 'k':
+            options.max_clause_size = atoi(optarg);
+            break;
+        case 'o':
+            options.out_dir = optarg;
+            break;
+        case 'V':
+            options.verbose = true;
+            break;
+        case 'S':
+            symmetry.enabled = true;
+            break;
+        case 'b':
+            backbone.enabled = true;
+            break;
+        case 'B':
+            bva.enabled = true;
+            options.grids = true;
+            break;
+        case 'L':
+            lucky.enabled = false;
+            break;
+        case 'm':
+            simulation.enabled = true;
+            simulation.budget = 1000;
+            break;
+        case 'P':
+            probing.enabled = true;
+            break;
+        case 'W':
+            elimination.enabled = true;
+            options.gates = true;
+            break;
+        case 'E':
+            if (!parse_heuristic(optarg, &heuristic))
+            {
+                fprintf(stderr, "Unknown heuristic: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            printf("Usage: %s [--iterations N] [--seed S] [--max-vars V] [--max-clauses C] [--max-size K] [--out-dir DIR] [--verbose] [--symmetry] [--backbone] [--bva] [--no-lucky] [--simulate] [--probe] [--bve] [--heuristic NAME]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (options.max_vars < 1 || options.max_vars > 20 || options.max_clauses < 1 || options.max_clause_size < 1)
+    {
+        fprintf(stderr, "Need 1 <= max-vars <= 20, max-clauses >= 1, max-size >= 1\n");
+        return 1;
+    }
+
+    if (symmetry.enabled && backbone.enabled)
+    {
+        fprintf(stderr, "Symmetry breaking removes models, --backbone cannot be combined with --symmetry\n");
+        return 1;
+    }
+    if (elimination.enabled && backbone.enabled)
+    {
+        fprintf(stderr, "Eliminated variables do not take part in the search, --backbone cannot be combined with --bve\n");
+        return 1;
+    }
+
+    // The search must never hit the default CPU limit on these sizes
+    limits.cpu_seconds = 0;
+
+    Rng rng;
+    rng_seed(&rng, options.seed);
+
+    long failures = 0, num_sat = 0;
+    for (long iter = 0; iter < options.iterations; iter++)
+    {
+        Cnf *cnf = cnf_random(&rng, &options);
+        simulation.seed = options.seed + (uint64_t)iter; // Other lanes and phases for every formula
+        FuzzOutcome outcome = check_cnf(cnf);
+        num_sat += brute_force_sat(cnf);
+
+        if (outcome != FUZZ_OK)
+        {
+            failures++;
+            Cnf *small = shrink(cnf, outcome);
+
+            char *path = NULL;
+            if (asprintf(&path, "%s/fuzz-%llu-%ld.cnf", options.out_dir, (unsigned long long)options.seed, iter) >= 0)
+            {
+                FILE *out = fopen(path, "w");
+                if (out)
+                {
+                    fprintf(out, "c %s (seed %llu, iteration %ld)\n", outcome_names[outcome], (unsigned long long)options.seed, iter);
+                    cnf_write(out, small);
+                    fclose(out);
+                }
+                printf("FAIL iteration %ld: %s, shrunk from %d to %d clauses -> %s\n", iter, outcome_names[outcome],
+                       cnf->numClauses, small->numClauses, path);
+                free(path);
+            }
+            cnf_free(small);
+        }
+        else if (options.verbose)
+        {
+            printf("ok   iteration %ld: %d vars, %d clauses\n", iter, cnf->numVars, cnf->numClauses);
+        }
+
+        cnf_free(cnf);
+    }
+
+    printf("Fuzzed %ld formulas (%ld SAT, %ld UNSAT): %ld failures\n", options.iterations, num_sat,
+           options.iterations - num_sat, failures);
+    // Preprocessing counters are not reset per formula, they show how often it fired
+    if (lucky.enabled)
+    {
+        printf("Lucky phases found a model in %ld checks\n", lucky_solved);
+    }
+    if (simulation.enabled)
+    {
+        printf("Simulation found a model for %ld searches\n", simulation_solved);
+    }
+    if (probing.enabled)
+    {
+        printf("Probing found %d failed literals, added %d hyper-binary resolvents and removed %d binary clauses\n",
+               probing.failed, probing.hyper_binary, probing.reduced);
+    }
+    if (bva.enabled)
+    {
+        printf("BVA added %d variables, replacing %d clauses by %d\n", bva.vars_added, bva.clauses_removed,
+               bva.clauses_added);
+    }
+    if (elimination.enabled)
+    {
+        printf("BVE eliminated %d variables (%d AND, %d XOR, %d ITE definitions), replacing %d clauses by %d\n",
+               elimination.eliminated, elimination.definitions[GATE_AND], elimination.definitions[GATE_XOR],
+               elimination.definitions[GATE_ITE], elimination.clauses_removed, elimination.clauses_added);
+    }
+    return failures > 0 ? 1 : 0;
+}
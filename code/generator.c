@@ -0,0 +1,637 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <getopt.h>
+#include "rng.h"
+
+// Instance generator for scaling studies. Every family is fully determined by
+// its parameters and the seed, which are recorded in the DIMACS header comments.
+
+typedef struct
+{
+    const char *family;
+    int num_vars;
+    int k;
+    double ratio;
+    long num_clauses;
+    int width;
+    int colors;
+    double degree;
+    int communities;
+    double locality;
+    bool planted;
+    uint64_t seed;
+    const char *output;
+} GenConfig;
+
+// Direct encoding of an XOR constraint is exponential in its width, longer
+// constraints are split into chunks linked by auxiliary variables.
+#define MAX_XOR_CHUNK 4
+
+void print_header(FILE *out, const GenConfig *config, long numVars, long numClauses)
+{
+    fprintf(out, "c generated by sat_generator\n");
+    fprintf(out, "c family %s seed %llu\n", config->family, (unsigned long long)config->seed);
+    fprintf(out, "p cnf %ld %ld\n", numVars, numClauses);
+}
+
+// Uniform random k-SAT: each clause has k distinct variables with random signs
+void gen_random_ksat(FILE *out, const GenConfig *config, Rng *rng)
+{
+    int n = config->num_vars;
+    int k = config->k;
+    long m = config->num_clauses > 0 ? config->num_clauses : (long)(config->ratio * n + 0.5);
+
+    fprintf(out, "c random %d-SAT n=%d m=%ld ratio=%.3f\n", k, n, m, (double)m / n);
+    print_header(out, config, n, m);
+
+    int *vars = malloc(sizeof(int) * k);
+    for (long c = 0; c < m; c++)
+    {
+        for (int i = 0; i < k; i++)
+        {
+            bool fresh;
+            do
+            {
+                vars[i] = (int)rng_below(rng, n) + 1;
+                fresh = true;
+                for (int j = 0; j < i; j++)
+                {
+                    if (vars[j] == vars[i])
+                    {
+                        fresh = false;
+                        break;
+                    }
+                }
+            } while (!fresh);
+
+            fprintf(out, "%d ", (rng_next(rng) & 1) ? -vars[i] : vars[i]);
+        }
+        fprintf(out, "0\n");
+    }
+
+    free(vars);
+}
+
+// Modular random k-SAT: the variables are shuffled into equal communities, and
+// with probability locality a clause takes all its variables from one community,
+// otherwise from the whole formula (Giraldez-Cru and Levy's community model)
+void gen_community(FILE *out, const GenConfig *config, Rng *rng)
+{
+    int n = config->num_vars;
+    int k = config->k;
+    int q = config->communities;
+    long m = config->num_clauses > 0 ? config->num_clauses : (long)(config->ratio * n + 0.5);
+
+    fprintf(out, "c community %d-SAT n=%d m=%ld communities=%d locality=%.3f\n", k, n, m, q, config->locality);
+    print_header(out, config, n, m);
+
+    // Community c holds perm[start[c] .. start[c + 1])
+    int *perm = malloc(sizeof(int) * n);
+    for (int i = 0; i < n; i++)
+    {
+        perm[i] = i + 1;
+    }
+    for (int i = n - 1; i > 0; i--)
+    {
+        int j = (int)rng_below(rng, i + 1);
+        int t = perm[i];
+        perm[i] = perm[j];
+        perm[j] = t;
+    }
+    int *start = malloc(sizeof(int) * (q + 1));
+    for (int c = 0; c <= q; c++)
+    {
+        start[c] = (int)((long)n * c / q);
+    }
+
+    int *vars = malloc(sizeof(int) * k);
+    for (long c = 0; c < m; c++)
+    {
+        int from = 0, size = n;
+        if (rng_double(rng) < config->locality)
+        {
+            int community = (int)rng_below(rng, q);
+            from = start[community];
+            size = start[community + 1] - from;
+        }
+
+        for (int i = 0; i < k; i++)
+        {
+            bool fresh;
+            do
+            {
+                vars[i] = perm[from + rng_below(rng, size)];
+                fresh = true;
+                for (int j = 0; j < i; j++)
+                {
+                    if (vars[j] == vars[i])
+                    {
+                        fresh = false;
+                        break;
+                    }
+                }
+            } while (!fresh);
+
+            fprintf(out, "%d ", (rng_next(rng) & 1) ? -vars[i] : vars[i]);
+        }
+        fprintf(out, "0\n");
+    }
+
+    free(vars);
+    free(start);
+    free(perm);
+}
+
+// Pigeonhole: n+1 pigeons into n holes, always UNSAT
+void gen_pigeonhole(FILE *out, const GenConfig *config)
+{
+    int holes = config->num_vars;
+    int pigeons = holes + 1;
+    long numVars = (long)pigeons * holes;
+    long numClauses = pigeons + (long)holes * pigeons * (pigeons - 1) / 2;
+
+    fprintf(out, "c pigeonhole pigeons=%d holes=%d\n", pigeons, holes);
+    print_header(out, config, numVars, numClauses);
+
+    // Every pigeon sits in some hole
+    for (int p = 0; p < pigeons; p++)
+    {
+        for (int h = 0; h < holes; h++)
+        {
+            fprintf(out, "%ld ", (long)p * holes + h + 1);
+        }
+        fprintf(out, "0\n");
+    }
+
+    // No two pigeons share a hole
+    for (int h = 0; h < holes; h++)
+    {
+        for (int p1 = 0; p1 < pigeons; p1++)
+        {
+            for (int p2 = p1 + 1; p2 < pigeons; p2++)
+            {
+                fprintf(out, "-%ld -%ld 0\n", (long)p1 * holes + h + 1, (long)p2 * holes + h + 1);
+            }
+        }
+    }
+}
+
+// Emit every clause forbidding an assignment of vars with the wrong parity
+void emit_xor_chunk(FILE *out, const long *vars, int len, int parity)
+{
+    for (int pattern = 0; pattern < (1 << len); pattern++)
+    {
+        if (__builtin_parity(pattern) == parity)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < len; i++)
+        {
+            bool value = (pattern >> i) & 1;
+            fprintf(out, "%ld ", value ? -vars[i] : vars[i]);
+        }
+        fprintf(out, "0\n");
+    }
+}
+
+// Number of auxiliary variables and clauses needed for one XOR of a given width
+void xor_cost(int width, long *aux, long *clauses)
+{
+    *aux = 0;
+    *clauses = 0;
+    while (width > MAX_XOR_CHUNK)
+    {
+        *clauses += 1L << (MAX_XOR_CHUNK - 1);
+        (*aux)++;
+        width -= MAX_XOR_CHUNK - 2;
+    }
+    *clauses += 1L << (width - 1);
+}
+
+// Random parity (XOR) constraints, planted instances are SAT by construction
+void gen_parity(FILE *out, const GenConfig *config, Rng *rng)
+{
+    int n = config->num_vars;
+    int w = config->width;
+    long m = config->num_clauses > 0 ? config->num_clauses : (long)(config->ratio * n + 0.5);
+
+    long aux_per, clauses_per;
+    xor_cost(w, &aux_per, &clauses_per);
+
+    fprintf(out, "c parity n=%d constraints=%ld width=%d planted=%d\n", n, m, w, config->planted);
+    print_header(out, config, n + m * aux_per, m * clauses_per);
+
+    bool *hidden = malloc(sizeof(bool) * (n + 1));
+    for (int v = 1; v <= n; v++)
+    {
+        hidden[v] = rng_next(rng) & 1;
+    }
+
+    long *vars = malloc(sizeof(long) * w);
+    long next_aux = n + 1;
+    for (long c = 0; c < m; c++)
+    {
+        int parity = 0;
+        for (int i = 0; i < w; i++)
+        {
+            bool fresh;
+            do
+            {
+                vars[i] = rng_below(rng, n) + 1;
+                fresh = true;
+                for (int j = 0; j < i; j++)
+                {
+                    if (vars[j] == vars[i])
+                    {
+                        fresh = false;
+                        break;
+                    }
+                }
+            } while (!fresh);
+            parity ^= hidden[vars[i]];
+        }
+
+        if (!config->planted)
+        {
+            parity = rng_next(rng) & 1;
+        }
+
+        // Chain: t = x1 ^ x2 ^ x3 becomes the first variable of the remainder
+        long chunk[MAX_XOR_CHUNK];
+        int start = 0, len = w;
+        while (len > MAX_XOR_CHUNK)
+        {
+            for (int i = 0; i < MAX_XOR_CHUNK - 1; i++)
+            {
+                chunk[i] = vars[start + i];
+            }
+            chunk[MAX_XOR_CHUNK - 1] = next_aux;
+            emit_xor_chunk(out, chunk, MAX_XOR_CHUNK, 0);
+
+            start += MAX_XOR_CHUNK - 2;
+            len -= MAX_XOR_CHUNK - 2;
+            vars[start] = next_aux++;
+        }
+        emit_xor_chunk(out, vars + start, len, parity);
+    }
+
+    free(vars);
+    free(hidden);
+}
+
+int compare_edges(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Random graph k-coloring, planted graphs only connect differently colored vertices
+void gen_coloring(FILE *out, const GenConfig *config, Rng *rng)
+{
+    int n = config->num_vars;
+    int k = config->colors;
+    long m = config->num_clauses > 0 ? config->num_clauses : (long)(config->degree * n / 2 + 0.5);
+
+    int *color = malloc(sizeof(int) * n);
+    for (int v = 0; v < n; v++)
+    {
+        color[v] = rng_below(rng, k);
+    }
+    if (config->planted)
+    {
+        color[1] = (color[0] + 1) % k; // guarantees at least one admissible edge
+    }
+
+    uint64_t *edges = malloc(sizeof(uint64_t) * m);
+    for (long e = 0; e < m; e++)
+    {
+        uint32_t u, v;
+        do
+        {
+            u = rng_below(rng, n);
+            v = rng_below(rng, n);
+        } while (u == v || (config->planted && color[u] == color[v]));
+
+        if (u > v)
+        {
+            uint32_t t = u;
+            u = v;
+            v = t;
+        }
+        edges[e] = ((uint64_t)u << 32) | v;
+    }
+
+    // Drop duplicate edges so every clause is distinct
+    qsort(edges, m, sizeof(uint64_t), compare_edges);
+    long unique = 0;
+    for (long e = 0; e < m; e++)
+    {
+        if (unique == 0 || edges[unique - 1] != edges[e])
+        {
+            edges[unique++] = edges[e];
+        }
+    }
+
+    long numVars = (long)n * k;
+    long numClauses = n + (long)n * k * (k - 1) / 2 + unique * k;
+
+    fprintf(out, "c coloring vertices=%d edges=%ld colors=%d planted=%d\n", n, unique, k, config->planted);
+    print_header(out, config, numVars, numClauses);
+
+    for (int v = 0; v < n; v++)
+    {
+        for (int c = 0; c < k; c++)
+        {
+            fprintf(out, "%ld ", (long)v * k + c + 1);
+        }
+        fprintf(out, "0\n");
+
+        for (int c1 = 0; c1 < k; c1++)
+        {
+            for (int c2 = c1 + 1; c2 < k; c2++)
+            {
+                fprintf(out, "-%ld -%ld 0\n", (long)v * k + c1 + 1, (long)v * k + c2 + 1);
+            }
+        }
+    }
+
+    for (long e = 0; e < unique; e++)
+    {
+        long u = edges[e] >> 32, v = edges[e] & 0xffffffffu;
+        for (int c = 0; c < k; c++)
+        {
+            fprintf(out, "-%ld -%ld 0\n", u * k + c + 1, v * k + c + 1);
+        }
+    }
+
+    free(edges);
+    free(color);
+}
+
+// Random circuit of 2-input AND, 2-input XOR and ITE gates, each reading earlier
+// signals with random signs, in the Tseitin encoding. The last width gate
+// outputs are asserted: to their values under a hidden input assignment when
+// planted (SAT by construction), to random values otherwise.
+void gen_circuit(FILE *out, const GenConfig *config, Rng *rng)
+{
+    int n = config->num_vars;
+    long gates = config->num_clauses > 0 ? config->num_clauses : (long)(config->ratio * n + 0.5);
+    long numVars = n + gates;
+    int asserted = config->width < gates ? config->width : (int)gates;
+
+    int *type = malloc(sizeof(int) * gates);
+    long(*in)[3] = malloc(sizeof(long[3]) * gates);
+    bool *value = malloc(sizeof(bool) * (numVars + 1));
+    long numClauses = asserted;
+    for (int v = 1; v <= n; v++)
+    {
+        value[v] = rng_next(rng) & 1;
+    }
+    for (long g = 0; g < gates; g++)
+    {
+        long signals = n + g;
+        type[g] = (int)rng_below(rng, 3);
+        int arity = type[g] == 2 ? 3 : 2;
+        if (signals < arity)
+        {
+            type[g] = 0;
+            arity = 2;
+        }
+        for (int i = 0; i < arity; i++)
+        {
+            bool fresh;
+            do
+            {
+                in[g][i] = rng_below(rng, signals) + 1;
+                fresh = true;
+                for (int j = 0; j < i; j++)
+                {
+                    fresh &= in[g][j] != in[g][i];
+                }
+            } while (!fresh && signals >= arity);
+            if (rng_next(rng) & 1)
+            {
+                in[g][i] = -in[g][i];
+            }
+        }
+
+        bool x[3];
+        for (int i = 0; i < arity; i++)
+        {
+            x[i] = in[g][i] > 0 ? value[in[g][i]] : !value[-in[g][i]];
+        }
+        value[n + g + 1] = type[g] == 0 ? x[0] && x[1] : type[g] == 1 ? x[0] != x[1] : (x[0] ? x[1] : x[2]);
+        numClauses += type[g] == 0 ? 3 : 4;
+    }
+
+    fprintf(out, "c circuit inputs=%d gates=%ld asserted=%d planted=%d\n", n, gates, asserted, config->planted);
+    print_header(out, config, numVars, numClauses);
+
+    for (long g = 0; g < gates; g++)
+    {
+        long o = n + g + 1, a = in[g][0], b = in[g][1];
+        if (type[g] == 0)
+        {
+            fprintf(out, "%ld %ld 0\n%ld %ld 0\n%ld %ld %ld 0\n", -o, a, -o, b, o, -a, -b);
+        }
+        else if (type[g] == 1)
+        {
+            fprintf(out, "%ld %ld %ld 0\n%ld %ld %ld 0\n%ld %ld %ld 0\n%ld %ld %ld 0\n", -o, a, b, -o, -a, -b, o, -a, b,
+                    o, a, -b);
+        }
+        else
+        {
+            // o = ITE(a, b, c); only these gates have a third input
+            long c = in[g][2];
+            fprintf(out, "%ld %ld %ld 0\n%ld %ld %ld 0\n%ld %ld %ld 0\n%ld %ld %ld 0\n", -o, -a, b, -o, a, c, o, -a, -b,
+                    o, a, -c);
+        }
+    }
+    for (long o = numVars - asserted + 1; o <= numVars; o++)
+    {
+        bool target = config->planted ? value[o] : (rng_next(rng) & 1);
+        fprintf(out, "%ld 0\n", target ? o : -o);
+    }
+
+    free(type);
+    free(in);
+    free(value);
+}
+
+void print_usage(const char *prog)
+{
+    printf("Usage: %s <random|community|php|parity|coloring|circuit> [options]\n", prog);
+    printf("  -n, --vars N         Variables (random, community, parity), holes (php), vertices (coloring)\n");
+    printf("                       or inputs (circuit)\n");
+    printf("  -k, --k K            Literals per clause for random and community k-SAT (default 3)\n");
+    printf("  -r, --ratio R        Clause/variable ratio for random, community and parity, gates per input\n");
+    printf("                       for circuit (default 4.26)\n");
+    printf("  -m, --clauses M      Exact number of clauses, constraints, edges or gates\n");
+    printf("  -w, --width W        Variables per parity constraint, asserted circuit outputs (default 3)\n");
+    printf("  -c, --colors C       Colors for graph coloring (default 3)\n");
+    printf("  -d, --degree D       Average vertex degree for coloring (default 4.0)\n");
+    printf("  -q, --communities Q  Communities for the community family (default 10)\n");
+    printf("  -L, --locality P     Fraction of clauses inside one community (default 0.8)\n");
+    printf("  -p, --planted        Plant a solution (parity, coloring, circuit)\n");
+    printf("  -s, --seed S         Random seed (default 1)\n");
+    printf("  -o, --output FILE    Output file (default stdout)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    GenConfig config = {NULL, 50, 3, 4.26, 0, 3, 3, 4.0, 10, 0.8, false, 1, NULL};
+
+    static struct option long_options[] = {
+        {"vars", required_argument, 0, 'n'},
+        {"k", required_argument, 0, 'k'},
+        {"ratio", required_argument, 0, 'r'},
+        {"clauses", required_argument, 0, 'm'},
+        {"width", required_argument, 0, 'w'},
+        {"colors", required_argument, 0, 'c'},
+        {"degree", required_argument, 0, 'd'},
+        {"communities", required_argument, 0, 'q'},
+        {"locality", required_argument, 0, 'L'},
+        {"planted", no_argument, 0, 'p'},
+        {"seed", required_argument, 0, 's'},
+        {"output", required_argument, 0, 'o'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:k:r:m:w:c:d:q:L:ps:o:h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            config.num_vars = atoi(optarg);
+            break;
+        case 'k':
+            config.k = atoi(optarg);
+            break;
+        case 'r':
+            config.ratio = atof(optarg);
+            break;
+        case 'm':
+            config.num_clauses = atol(optarg);
+            break;
+        case 'w':
+            config.width = atoi(optarg);
+            break;
+        case 'c':
+            config.colors = atoi(optarg);
+            break;
+        case 'd':
+            config.degree = atof(optarg);
+            break;
+        case 'q':
+            config.communities = atoi(optarg);
+            break;
+        case 'L':
+            config.locality = atof(optarg);
+            break;
+        case 'p':
+            config.planted = true;
+            break;
+        case 's':
+            config.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'o':
+            config.output = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind != argc - 1)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    config.family = argv[optind];
+
+    if (config.num_vars < 1 || config.k < 1 || config.k > config.num_vars || config.width < 1 ||
+        config.width > config.num_vars || config.colors < 1 || config.num_clauses < 0)
+    {
+        fprintf(stderr, "Invalid parameters\n");
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (config.output)
+    {
+        out = fopen(config.output, "w");
+        if (!out)
+        {
+            perror(config.output);
+            return 1;
+        }
+    }
+
+    Rng rng;
+    rng_seed(&rng, config.seed);
+
+    int status = 0;
+    if (strcmp(config.family, "random") == 0)
+    {
+        gen_random_ksat(out, &config, &rng);
+    }
+    else if (strcmp(config.family, "community") == 0)
+    {
+        if (config.communities < 1 || config.num_vars / config.communities < config.k || config.locality < 0 ||
+            config.locality > 1)
+        {
+            fprintf(stderr, "Community needs k variables per community and a locality in [0, 1]\n");
+            status = 1;
+        }
+        else
+        {
+            gen_community(out, &config, &rng);
+        }
+    }
+    else if (strcmp(config.family, "php") == 0)
+    {
+        gen_pigeonhole(out, &config);
+    }
+    else if (strcmp(config.family, "parity") == 0)
+    {
+        gen_parity(out, &config, &rng);
+    }
+    else if (strcmp(config.family, "coloring") == 0)
+    {
+        if (config.num_vars < 2 || (config.planted && config.colors < 2))
+        {
+            fprintf(stderr, "Coloring needs at least 2 vertices (and 2 colors when planted)\n");
+            status = 1;
+        }
+        else
+        {
+            gen_coloring(out, &config, &rng);
+        }
+    }
+    else if (strcmp(config.family, "circuit") == 0)
+    {
+        gen_circuit(out, &config, &rng);
+    }
+    else
+    {
+        fprintf(stderr, "Unknown family: %s\n", config.family);
+        status = 1;
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    return status;
+}
@@ -0,0 +1,353 @@
+// Microbenchmarks for the solver kernels: watch-list propagation, undo stack
+// push/undo, superset removal and DIMACS parsing. The solver is compiled into
+// this binary so the kernels are measured exactly as they are in sat_solver.
+#define SAT_SOLVER_NO_MAIN
+#include "sat_solver.c"
+#include <fcntl.h>
+#include "rng.h"
+
+typedef struct
+{
+    int reps;
+    double scale;
+    uint64_t seed;
+    const char *kernel;
+} BenchOptions;
+
+typedef struct
+{
+    const char *kernel;
+    const char *unit;
+    double *samples;
+    int count;
+} BenchSeries;
+
+int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Report median, min and max throughput over the repetitions
+void report_series(BenchSeries *series)
+{
+    qsort(series->samples, series->count, sizeof(double), compare_double);
+    double median = series->samples[series->count / 2];
+    if (series->count % 2 == 0)
+    {
+        median = 0.5 * (series->samples[series->count / 2 - 1] + series->samples[series->count / 2]);
+    }
+
+    double min = series->samples[0], max = series->samples[series->count - 1];
+    printf("%-14s %14.2f %14.2f %14.2f  %-12s (spread %.1f%%)\n", series->kernel, median, min, max,
+           series->unit, median > 0 ? 100.0 * (max - min) / median : 0.0);
+}
+
+// Random formula built in memory with distinct variables per clause: the first
+// numBinary clauses are binary, the rest have k literals
+Formula *random_formula(Rng *rng, int numVars, int numClauses, int k, int numBinary)
+{
+    Formula *formula = malloc(sizeof(Formula));
+    formula->numVars = numVars;
+    formula->numClauses = numClauses;
+    formula->clauses = malloc(sizeof(Clause) * numClauses);
+
+    for (int i = 0; i < numClauses; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        clause->size = i < numBinary ? 2 : k;
+        clause->satisfied = false;
+        clause->literals = malloc(sizeof(Literal) * clause->size);
+        for (int j = 0; j < clause->size; j++)
+        {
+            bool fresh;
+            do
+            {
+                clause->literals[j].var = (int)rng_below(rng, numVars) + 1;
+                fresh = true;
+                for (int l = 0; l < j; l++)
+                {
+                    if (clause->literals[l].var == clause->literals[j].var)
+                    {
+                        fresh = false;
+                        break;
+                    }
+                }
+            } while (!fresh);
+            clause->literals[j].neg = rng_next(rng) & 1;
+        }
+    }
+
+    return formula;
+}
+
+Formula *copy_formula(const Formula *src)
+{
+    Formula *formula = malloc(sizeof(Formula));
+    *formula = *src;
+    formula->clauses = malloc(sizeof(Clause) * src->numClauses);
+    for (int i = 0; i < src->numClauses; i++)
+    {
+        formula->clauses[i] = src->clauses[i];
+        formula->clauses[i].literals = malloc(sizeof(Literal) * src->clauses[i].size);
+        memcpy(formula->clauses[i].literals, src->clauses[i].literals, sizeof(Literal) * src->clauses[i].size);
+    }
+
+    return formula;
+}
+
+// Watch-list propagation: a few random decisions, propagate to fixpoint, undo.
+// The binary clauses form implication chains so every round propagates.
+void bench_propagate(const BenchOptions *options, BenchSeries *series)
+{
+    Rng rng;
+    rng_seed(&rng, options->seed);
+
+    int numVars = (int)(2000 * options->scale);
+    Formula *formula = random_formula(&rng, numVars, numVars * 3, 3, numVars * 9 / 10);
+    WatchTable *wtable = build_watch_table(formula);
+    int *assignments = malloc(sizeof(int) * (numVars + 1));
+    for (int i = 0; i <= numVars; i++)
+    {
+        assignments[i] = -1;
+    }
+    UndoStack stack = {NULL};
+
+    const int decisions = 200;
+    for (int rep = -1; rep < options->reps; rep++)
+    {
+        unsigned long long before = stats.propagations;
+        double start = wall_seconds();
+        for (int d = 0; d < decisions; d++)
+        {
+            // Several decisions per round so propagation has something to do
+            for (int k = 0; k < 8; k++)
+            {
+                int var = (int)rng_below(&rng, numVars) + 1;
+                if (assignments[var] == -1)
+                {
+                    assignments[var] = rng_next(&rng) & 1;
+                    push_assignment(&stack, var);
+                }
+            }
+            satisfy_clauses_after_assignment(formula, assignments, &stack);
+            unit_propagate_2watchlit(formula, assignments, &stack, wtable);
+            undo_to_checkpoint(&stack, NULL, formula, assignments, wtable);
+        }
+        double elapsed = wall_seconds() - start;
+
+        // rep -1 is the warm-up round
+        if (rep >= 0)
+        {
+            series->samples[series->count++] = (stats.propagations - before) / elapsed / 1e6;
+        }
+    }
+
+    free(assignments);
+    free_watchtable(wtable);
+    free_formula(formula);
+}
+
+// Undo stack: push a mix of entries, then undo them, repeated ("redo")
+void bench_undo(const BenchOptions *options, BenchSeries *series)
+{
+    int numVars = (int)(100000 * options->scale);
+    Formula formula = {numVars, numVars, calloc(numVars, sizeof(Clause))};
+    WatchTable *wtable = init_empty_watch_table(&formula);
+    int *assignments = malloc(sizeof(int) * (numVars + 1));
+    UndoStack stack = {NULL};
+
+    for (int rep = -1; rep < options->reps; rep++)
+    {
+        double start = wall_seconds();
+        for (int round = 0; round < 10; round++)
+        {
+            for (int var = 1; var <= numVars; var++)
+            {
+                assignments[var] = 1;
+                push_assignment(&stack, var);
+                formula.clauses[var - 1].satisfied = true;
+                push_clause_satisfy(&stack, var - 1);
+            }
+            undo_to_checkpoint(&stack, NULL, &formula, assignments, wtable);
+        }
+        double elapsed = wall_seconds() - start;
+
+        if (rep >= 0)
+        {
+            series->samples[series->count++] = 10.0 * 2 * numVars / elapsed / 1e6;
+        }
+    }
+
+    free(assignments);
+    free_watchtable(wtable);
+    free(formula.clauses);
+}
+
+// Superset removal on random clauses, a quarter of them extended copies of others
+void bench_subsumption(const BenchOptions *options, BenchSeries *series)
+{
+    Rng rng;
+    rng_seed(&rng, options->seed);
+
+    int numClauses = (int)(1500 * options->scale);
+    Formula *base = random_formula(&rng, numClauses / 4 + 10, numClauses, 3, 0);
+    for (int i = 0; i < numClauses / 4; i++)
+    {
+        Clause *target = &base->clauses[rng_below(&rng, numClauses)];
+        Clause *source = &base->clauses[rng_below(&rng, numClauses)];
+        if (target == source)
+            continue;
+
+        free(target->literals);
+        target->size = source->size + 1;
+        target->literals = malloc(sizeof(Literal) * target->size);
+        memcpy(target->literals, source->literals, sizeof(Literal) * source->size);
+        target->literals[source->size].var = base->numVars;
+        target->literals[source->size].neg = false;
+    }
+
+    for (int rep = -1; rep < options->reps; rep++)
+    {
+        Formula *formula = copy_formula(base);
+        double start = wall_seconds();
+        remove_supersets(formula);
+        double elapsed = wall_seconds() - start;
+
+        if (rep >= 0)
+        {
+            series->samples[series->count++] = numClauses / elapsed / 1e3;
+        }
+        free_formula(formula);
+    }
+
+    free_formula(base);
+}
+
+// DIMACS parsing from a generated file; parse_formula's header line is silenced
+void bench_parse(const BenchOptions *options, BenchSeries *series)
+{
+    Rng rng;
+    rng_seed(&rng, options->seed);
+
+    char path[] = "/tmp/sat_microbench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        perror("mkstemp");
+        return;
+    }
+
+    FILE *file = fdopen(fd, "w");
+    int numVars = (int)(50000 * options->scale);
+    int numClauses = (int)(numVars * 4.26);
+    fprintf(file, "c microbench\np cnf %d %d\n", numVars, numClauses);
+    for (int i = 0; i < numClauses; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            int var = (int)rng_below(&rng, numVars) + 1;
+            fprintf(file, "%d ", (rng_next(&rng) & 1) ? -var : var);
+        }
+        fprintf(file, "0\n");
+    }
+    long bytes = ftell(file);
+    fclose(file);
+
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+
+    for (int rep = -1; rep < options->reps; rep++)
+    {
+        dup2(devnull, STDOUT_FILENO);
+        double start = wall_seconds();
+        Formula *formula = parse_formula(path);
+        double elapsed = wall_seconds() - start;
+        fflush(stdout);
+        dup2(saved_stdout, STDOUT_FILENO);
+
+        if (rep >= 0)
+        {
+            series->samples[series->count++] = bytes / elapsed / 1e6;
+        }
+        free_formula(formula);
+    }
+
+    close(devnull);
+    close(saved_stdout);
+    unlink(path);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options = {9, 1.0, 42, NULL};
+
+    static struct option long_options[] = {
+        {"reps", required_argument, 0, 'r'},
+        {"scale", required_argument, 0, 's'},
+        {"seed", required_argument, 0, 'S'},
+        {"kernel", required_argument, 0, 'k'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:s:S:k:h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            options.reps = atoi(optarg);
+            break;
+        case 's':
+            options.scale = atof(optarg);
+            break;
+        case 'S':
+            options.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'k':
+            options.kernel = optarg;
+            break;
+        default:
+            printf("Usage: %s [--reps N] [--scale S] [--seed S] [--kernel propagate|undo|subsumption|parse]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (options.reps < 1 || options.scale <= 0)
+    {
+        fprintf(stderr, "Invalid --reps or --scale\n");
+        return 1;
+    }
+
+    struct
+    {
+        const char *name;
+        const char *unit;
+        void (*run)(const BenchOptions *, BenchSeries *);
+    } kernels[] = {
+        {"propagate", "Mprops/s", bench_propagate},
+        {"undo", "Mentries/s", bench_undo},
+        {"subsumption", "Kclauses/s", bench_subsumption},
+        {"parse", "MB/s", bench_parse},
+    };
+
+    printf("%-14s %14s %14s %14s  (reps %d, scale %.2f, seed %llu)\n", "kernel", "median", "min", "max",
+           options.reps, options.scale, (unsigned long long)options.seed);
+
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++)
+    {
+        if (options.kernel && strcmp(options.kernel, kernels[i].name) != 0)
+            continue;
+
+        BenchSeries series = {kernels[i].name, kernels[i].unit, malloc(sizeof(double) * options.reps), 0};
+        kernels[i].run(&options, &series);
+        if (series.count > 0)
+        {
+            report_series(&series);
+        }
+        free(series.samples);
+    }
+
+    return 0;
+}
@@ -5,7 +5,46 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <glib.h>
+#include "rng.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+// Compile-time feature switches, e.g. -DSAT_STATS=0. A disabled feature compiles
+// to nothing in the search loop; the Makefile builds the named variants.
+#ifndef SAT_STATS
+#define SAT_STATS 1 // Search counters (also needed for counter limits)
+#endif
+#ifndef SAT_TIMERS
+#define SAT_TIMERS 1 // Per-phase wall-clock timers
+#endif
+#ifndef SAT_PERF
+#define SAT_PERF 1 // --perf hardware counters
+#endif
+#ifndef SAT_TRACE
+#define SAT_TRACE 1 // --trace search trace
+#endif
+#ifndef SAT_PROOF
+#define SAT_PROOF 1 // --proof DRUP proof logging
+#endif
+#ifndef SAT_PURE_LITERAL
+#define SAT_PURE_LITERAL 1 // Pure literal elimination at every dpll call
+#endif
 
 // DPLL
 
@@ -62,15 +101,623 @@ typedef enum
     TIMEOUT
 } DPLLReturnType;
 
+typedef enum
+{
+    TIMER_PARSE,
+    TIMER_CACHE,
+    TIMER_SUPERSETS,
+    TIMER_PROBE,
+    TIMER_BVE,
+    TIMER_BVA,
+    TIMER_FEATURES,
+    TIMER_ORDER,
+    TIMER_SYMMETRY,
+    TIMER_WATCH_BUILD,
+    TIMER_LUCKY,
+    TIMER_SIMULATE,
+    TIMER_PROPAGATE,
+    TIMER_PURE_LITERAL,
+    TIMER_BACKTRACK,
+    NUM_TIMERS
+} TimerType;
+
+// Counters and per-phase timers, printed as a stats block at the end of a run.
+// Restarts and learned clauses stay at zero for plain DPLL.
+typedef struct
+{
+    unsigned long long decisions;
+    unsigned long long propagations;
+    unsigned long long conflicts;
+    unsigned long long watch_visits;
+    unsigned long long undo_entries;
+    unsigned long long restarts;
+    unsigned long long learned_clauses;
+    double timers[NUM_TIMERS];
+} SolverStats;
+
+typedef enum
+{
+    LIMIT_NONE,
+    LIMIT_WALL,
+    LIMIT_CPU,
+    LIMIT_DECISIONS,
+    LIMIT_CONFLICTS,
+    LIMIT_PROPAGATIONS,
+    LIMIT_INTERRUPT, // SIGINT or SIGTERM
+    NUM_LIMITS
+} LimitType;
+
+// Resource budgets, 0 means unlimited. Counter budgets are compared on every
+// dpll call, the clocks are only read every check_interval calls.
+typedef struct
+{
+    double wall_seconds;
+    double cpu_seconds;
+    unsigned long long decisions;
+    unsigned long long conflicts;
+    unsigned long long propagations;
+    unsigned int check_interval;
+} Limits;
+
+// Periodic progress line, reported from the amortized clock check
+typedef struct
+{
+    double interval;
+    double next_report;
+    double last_time;
+    unsigned long long last_decisions;
+    unsigned long long last_propagations;
+} Progress;
+
+typedef enum
+{
+    PERF_PHASE_PREPROCESS,
+    PERF_PHASE_PROPAGATE,
+    PERF_PHASE_BACKTRACK,
+    PERF_PHASE_DECISION,
+    NUM_PERF_PHASES
+} PerfPhase;
+
+typedef enum
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    NUM_PERF_EVENTS
+} PerfEvent;
+
+// Optional hardware counters (perf_event_open), read as one group at the start
+// and end of each phase. Events the kernel refuses are skipped, and if the
+// group cannot be opened at all the counters stay disabled.
+typedef struct
+{
+    bool requested;
+    bool enabled;
+    int leader;
+    int fds[NUM_PERF_EVENTS];
+    int slot[NUM_PERF_EVENTS]; // Position of the event in a group read, -1 if not opened
+    int num_open;
+    char error[128];
+    unsigned long long totals[NUM_PERF_PHASES][NUM_PERF_EVENTS];
+    unsigned long long calls[NUM_PERF_PHASES];
+} PerfCounters;
+
+typedef struct
+{
+    unsigned long long values[NUM_PERF_EVENTS];
+} PerfSample;
+
+typedef enum
+{
+    TRACE_DECISION,
+    TRACE_PROPAGATE,
+    TRACE_CONFLICT,
+    TRACE_BACKTRACK
+} TraceEventType;
+
+// Binary trace record. The file starts with TRACE_MAGIC, a version and the
+// record size; sat_trace converts it to folded stacks or Chrome trace JSON.
+typedef struct
+{
+    uint64_t time_ns;    // Since trace start
+    int32_t value;       // Decision/backtrack literal or number of propagations
+    uint32_t type_depth; // Event type in the low 8 bits, decision depth above
+} TraceRecord;
+
+#define TRACE_MAGIC "SATTRC01"
+#define TRACE_VERSION 1
+#define TRACE_RING_SIZE (1u << 16)
+
+// Single-producer ring buffer drained by a writer thread, so the search only
+// pays for a timestamp and a store per event
+typedef struct
+{
+    bool enabled;
+    TraceRecord *ring;
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    _Atomic bool stop;
+    FILE *file;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    struct timespec start;
+    unsigned long long records;
+    unsigned long long stalls;
+} Trace;
+
+// Symmetry detection: the CNF as a colored graph in CSR form
+typedef struct
+{
+    int numNodes;
+    int numLitNodes;
+    int *adj_start;
+    int *adj;
+    int *color;
+} SymGraph;
+
+// Ordered partition of the graph nodes. Cells are ranges of lab, identified by
+// their start position.
+typedef struct
+{
+    int numNodes;
+    int numCells;
+    int *lab;      // Nodes ordered by cell
+    int *cell_of;  // Start of each node's cell
+    int *cell_end; // For a cell start, one past the cell's last position
+} SymPartition;
+
+// Scratch arrays of the refinement, one entry per node
+typedef struct
+{
+    int *count;
+    int *touched;
+    int *cells;
+    bool *cell_mark;
+    int *queue;
+    bool *in_queue;
+} SymWork;
+
+// First path of the individualization-refinement search, and buffers for the
+// paths that are compared against it
+typedef struct
+{
+    const SymGraph *graph;
+    SymWork *work;
+    int depth;
+    SymPartition **path;   // Partition at each level before individualizing
+    int *target;           // Target cell per level
+    int *chosen;           // Node individualized per level on the first path
+    uint64_t *fingerprint; // Refinement fingerprint per level on the first path
+    SymPartition *leaf;
+    SymPartition **right;
+    int *perm;
+    int *mark;
+} SymSearch;
+
+#define SYM_MAX_PATH_ENTRIES (1u << 22)
+
+typedef struct
+{
+    bool enabled;
+    unsigned long long budget; // Adjacency entries scanned by refinement
+    unsigned long long steps;
+    int max_generators;
+    int max_chain;
+    bool exhausted;
+    int generators;
+    int clauses_added;
+    int aux_vars;
+} Symmetry;
+
+// Gate definitions recognized by variable elimination, with DIMACS literals:
+// output <-> AND of the inputs, output <-> inputs[0] XOR inputs[1], or
+// output <-> ITE(inputs[0], inputs[1], inputs[2]). Kept for the decision order.
+typedef enum
+{
+    GATE_AND,
+    GATE_XOR,
+    GATE_ITE,
+    NUM_GATE_TYPES
+} GateType;
+
+typedef struct
+{
+    GateType type;
+    int output;
+    int numInputs;
+    int *inputs;
+    bool eliminated; // The output was eliminated using this definition
+} Gate;
+
+// Lucky phases, tried before the search: every variable false or true, and the
+// same in variable order forwards or backwards with unit propagation after each
+// assignment. The first one without a conflict is a model; none of them
+// backtracks, so together they cost a few passes over the clauses.
+typedef enum
+{
+    LUCKY_ALL_FALSE,
+    LUCKY_ALL_TRUE,
+    LUCKY_FORWARD_FALSE,
+    LUCKY_FORWARD_TRUE,
+    LUCKY_BACKWARD_FALSE,
+    LUCKY_BACKWARD_TRUE,
+    NUM_LUCKY_PHASES
+} LuckyPhase;
+
+static const char *lucky_names[NUM_LUCKY_PHASES] = {"all-false",     "all-true",       "forward-false",
+                                                    "forward-true", "backward-false", "backward-true"};
+
+typedef struct
+{
+    bool enabled; // On unless --no-lucky
+    int tried;
+    int phase; // The phase that satisfied the formula, -1 if none did
+} Lucky;
+
+// Bit-parallel random simulation (--simulate): 64 random assignments, one per
+// bit of a word, are built together with unit propagation and then refined by
+// random flips in the clauses they falsify. A clause is evaluated for all of
+// them with a few word operations per literal. A lane that satisfies every
+// clause is a model; otherwise the lane falsifying the fewest clauses sets the
+// value each decision variable tries first.
+typedef struct
+{
+    bool enabled;
+    uint64_t seed;
+    unsigned long long budget; // Clause literals evaluated
+    unsigned long long steps;
+    bool exhausted;
+    int rounds;               // Flip rounds
+    unsigned long long flips; // Variables flipped, summed over the lanes
+    int initial_unsat;        // Falsified clauses of the best lane after propagation
+    int best_unsat;           // And after the flips, 0 for a model
+} Simulation;
+
+// Failed-literal probing (--probe): every literal is assumed and propagated. A
+// conflict makes its negation a unit. A longer clause that becomes unit under a
+// probe adds the hyper-binary resolvent (-d | u), d the dominator of its false
+// literals in the probe's implication tree, so later probes reach u over binary
+// clauses alone. After each round, a transitive reduction removes the binary
+// clauses whose implication also follows from a path of other binary clauses.
+typedef struct
+{
+    bool enabled;
+    unsigned long long budget; // Clause literals visited by probing and reduction
+    unsigned long long steps;
+    bool exhausted;
+    int rounds;
+    int probed;
+    int failed;       // Units from failed literals
+    int hyper_binary; // Hyper-binary resolvents added
+    int reduced;      // Binary clauses removed by transitive reduction
+} Probing;
+
+// Bounded variable elimination (--bve): a variable is replaced by the resolvents
+// of its clauses when there are no more of them than clauses removed. If the
+// variable is the output of a gate, only resolvents between gate and non-gate
+// clauses are needed; the others are tautologies or implied. The clauses of an
+// eliminated variable are kept on a stack to extend models to it.
+typedef struct
+{
+    bool enabled;
+    unsigned long long budget; // Clause literals visited while resolving
+    unsigned long long steps;
+    bool exhausted;
+    int max_occurrences; // Variables in more clauses are not tried
+    int max_resolvent;   // Longest resolvent allowed
+    int eliminated;
+    int clauses_removed;
+    int clauses_added;
+    int definitions[NUM_GATE_TYPES]; // Eliminations that used a gate
+    GArray *gates;                   // Every recognized Gate
+    GArray *stack;                   // Per clause: witness literal, other literals, size
+} Elimination;
+
+// Bounded variable addition (--bva): a grid of clauses (L_i | C_j) over literals
+// L_1..L_m and clause rests C_1..C_n, as in pairwise at-most-one encodings, is
+// replaced by (L_i | x) and (C_j | -x) with a fresh variable x: m * n clauses
+// become m + n. The fresh variables are numbered after the original ones.
+typedef struct
+{
+    bool enabled;
+    unsigned long long budget; // Clause literals visited while matching
+    unsigned long long steps;
+    bool exhausted;
+    int vars_added;
+    int clauses_removed;
+    int clauses_added;
+    int least_gain; // Fewest clauses removed minus added by one application
+} Bva;
+
+// Occurrence lists of the clause-rewriting preprocessors, indexed by literal
+// code. Removed clauses are dropped from the lists lazily, count holds the live
+// occurrences; the formula is compacted when the pass finishes.
+typedef struct
+{
+    Formula *formula;
+    int capacity;
+    int numCodes;
+    GArray **occurs;
+    int *count;
+    int *stamp;
+    int *tally;
+    int *paired; // BVA: clause a literal code was last paired with this round, or -1
+    int epoch;
+    bool *removed;
+    int *claimed; // BVA: epoch of the round in which a clause was paired
+    int removedCapacity;
+    GArray *queue; // BVA: max-heap of (count << 32 | code), entries may be stale
+} OccurrenceLists;
+
+// Decision order heuristics for var_sort
+typedef enum
+{
+    HEURISTIC_OCCURRENCE,
+    HEURISTIC_COMMUNITY,
+    NUM_HEURISTICS
+} Heuristic;
+
+static const char *heuristic_names[NUM_HEURISTICS] = {"occurrence", "community"};
+
+// Weighted undirected graph in CSR form for community detection. Nodes start as
+// variables; after aggregation a node is a community and self_weight holds the
+// weight of the edges inside it.
+typedef struct
+{
+    int numNodes;
+    int *adj_start;
+    int *adj;
+    double *weight;
+    double *self_weight;
+} WeightedGraph;
+
+// Clauses longer than this add no edges to the variable incidence graph, their
+// number of variable pairs grows quadratically
+#define COMMUNITY_MAX_CLAUSE 64
+
+typedef struct
+{
+    int count; // Communities with at least one edge
+    int levels;
+    double modularity;
+} Communities;
+
+// Instance features for configuration selection: size, clause-size histogram,
+// literal signs, variable degrees, community structure and a short probing run
+typedef enum
+{
+    FEATURE_LOG_VARS,
+    FEATURE_LOG_CLAUSES,
+    FEATURE_RATIO,
+    FEATURE_UNIT,
+    FEATURE_BINARY,
+    FEATURE_TERNARY,
+    FEATURE_SIZE_4_7,
+    FEATURE_SIZE_8_PLUS,
+    FEATURE_HORN,
+    FEATURE_POSITIVE,
+    FEATURE_DEGREE_MEAN,
+    FEATURE_DEGREE_CV,
+    FEATURE_DEGREE_MAX,
+    FEATURE_MODULARITY,
+    FEATURE_PROBE_PROPAGATIONS,
+    FEATURE_PROBE_CONFLICTS,
+    FEATURE_PROBE_SOLVED,
+    NUM_FEATURES
+} FeatureType;
+
+static const char *feature_names[NUM_FEATURES] = {
+    "log_vars", "log_clauses", "ratio", "unit", "binary", "ternary", "size_4_7", "size_8_plus",
+    "horn", "positive", "degree_mean", "degree_cv", "degree_max", "modularity", "probe_propagations", "probe_conflicts",
+    "probe_solved"};
+
+// Decisions of the probing run, enough to see how much one decision propagates
+#define PROBE_DECISIONS 50
+
+// Named configurations the selector chooses from (--config NAME)
+typedef struct
+{
+    const char *name;
+    Heuristic heuristic;
+    bool symmetry;
+} Preset;
+
+static const Preset presets[] = {
+    {"occurrence", HEURISTIC_OCCURRENCE, false},
+    {"community", HEURISTIC_COMMUNITY, false},
+    {"symmetry", HEURISTIC_OCCURRENCE, true},
+    {"community-symmetry", HEURISTIC_COMMUNITY, true},
+};
+
+#define NUM_PRESETS (int)(sizeof(presets) / sizeof(presets[0]))
+
+// k-nearest-neighbour selector: one row per training instance with its feature
+// vector, best preset and the PAR-2 score of every preset. Features are
+// standardized with the training mean and standard deviation.
+typedef struct
+{
+    int count;
+    int *preset;
+    double *features; // count x NUM_FEATURES
+    double *cost;     // count x NUM_PRESETS, negative if the preset was not run
+    double mean[NUM_FEATURES];
+    double scale[NUM_FEATURES];
+} SelectorModel;
+
+#define SELECTOR_K 3
+
+// Backbone mode: the literals true in every model. Candidates start as the first
+// model; each query asks for a model that flips at least one of a chunk of them.
+typedef struct
+{
+    bool enabled;
+    int chunk;     // Candidates per query at the start
+    int *literals; // Confirmed backbone literals (DIMACS)
+    int size;
+    int candidates; // Still open when the search stopped
+    unsigned long long queries;
+    unsigned long long sat_queries;
+    unsigned long long unsat_queries;
+} Backbone;
+
+// DRUP proof for UNSAT answers. Every dpll call that returns UNSAT adds the
+// negation of its decision path, which is RUP: either propagation under the path
+// conflicts, or both children already added the path extended by x and by -x.
+// The children's clauses are deleted again once the parent's is written, and the
+// root call adds the empty clause.
+typedef struct
+{
+    FILE *file;
+    unsigned long long added;
+    unsigned long long deleted;
+} Proof;
+
+// On-disk result cache (--cache DIR): one file per formula, named by a 128-bit
+// hash of the canonical clause set (sorted literals and clauses, duplicates and
+// tautologies dropped), so that reordered copies of an instance share an entry
+typedef struct
+{
+    const char *dir;
+    char key[33];       // Hex digest, empty until hashed
+    int canonicalClauses;
+    const char *status; // "off", "miss", "hit", "stale" (entry failed verification) or "bypass"
+} ResultCache;
+
+// Checkpoints of the main search (--checkpoint FILE) and their resumption
+// (--resume FILE). The search state of this solver is its guiding path: the
+// decided literals per level, -x in the first branch and x in the second unless
+// --simulate set the phase of x to true. With the formula and configuration
+// fixed, replaying the path reproduces every decision and phase; a second branch
+// means the first one was refuted and is skipped.
+typedef struct
+{
+    const char *path;
+    double interval; // Seconds between periodic writes
+    double next_write;
+    bool active;     // Only the main search is written and replayed
+    int written;
+    int numVars;     // Of the preprocessed formula the path belongs to
+    int numClauses;
+    int *resume_path;
+    int resume_depth;
+    bool replaying;  // Until the search reaches the resumed node
+    bool mismatch;   // The replayed decisions differ from the checkpoint
+    unsigned long long prior_decisions; // Counters and time of earlier runs
+    unsigned long long prior_propagations;
+    unsigned long long prior_conflicts;
+    double prior_seconds;
+} Checkpointing;
+
+#define CHECKPOINT_VERSION 2
+
+// Per-instance facts collected for the JSON stats record
+typedef struct
+{
+    const char *filename;
+    const char *result;
+    const char *limit;
+    int exit_code;
+    int numVars;
+    int numClauses;        // As parsed
+    int numClausesReduced; // After preprocessing
+    double cpu_time;
+    double wall_time;
+    const char *trace_file;
+    const char *preset;      // From --config or --auto-config, NULL otherwise
+    const double *features;  // NULL if not extracted
+} RunInfo;
+
+static const char *perf_phase_names[NUM_PERF_PHASES] = {"preprocess", "propagation", "backtrack", "decision"};
+
+static const char *timer_names[NUM_TIMERS] = {
+    "parse", "cache", "remove_supersets", "probe", "bve", "bva", "features", "decision_order", "symmetry", "watch_build", "lucky", "simulate", "propagation", "pure_literal", "backtrack"};
+
+static const struct
+{
+    const char *name;
+    bool enabled;
+} build_features[] = {
+    {"stats", SAT_STATS},
+    {"timers", SAT_TIMERS},
+    {"perf", SAT_PERF},
+    {"trace", SAT_TRACE},
+    {"proof", SAT_PROOF},
+    {"pure_literal", SAT_PURE_LITERAL},
+};
+
+// Hooks used in the search loop, empty when the feature is compiled out
+#if SAT_STATS
+#define STAT_INC(field) (stats.field++)
+#else
+#define STAT_INC(field) ((void)0)
+#endif
+
+#if SAT_TIMERS
+#define TIMER_START(t) ((t) = timer_start())
+#define TIMER_STOP(timer, t) timer_stop(timer, t)
+#else
+#define TIMER_START(t) ((void)(t))
+#define TIMER_STOP(timer, t) ((void)(t))
+#endif
+
+#if SAT_PERF
+#define PERF_START(sample) perf_start(&(sample))
+#define PERF_STOP(phase, sample) perf_stop(phase, &(sample))
+#else
+#define PERF_START(sample) ((void)(sample))
+#define PERF_STOP(phase, sample) ((void)(sample))
+#endif
+
+#if SAT_TRACE
+#define TRACE_EMIT(type, depth, value) trace_emit(type, depth, value)
+#else
+#define TRACE_EMIT(type, depth, value) ((void)0)
+#endif
+
+#if SAT_PROOF
+#define PROOF_UNSAT(depth) proof_unsat(depth)
+#else
+#define PROOF_UNSAT(depth) ((void)0)
+#endif
+
 static int *var_sort = NULL;
+static SolverStats stats;
+static double start_wall;
 static clock_t start_time;
-static double timeout_seconds = 3600.0; // 1 hour cutoff timer
+static Limits limits = {0.0, 3600.0, 0, 0, 0, 256}; // 1 hour CPU cutoff by default
+static LimitType limit_reached = LIMIT_NONE;
+static unsigned int clock_check_countdown = 0;
+static Progress progress = {0.0, 0.0, 0.0, 0, 0};
+static int search_depth = 0;
+static int trail_size = 0;
+static volatile sig_atomic_t interrupt_signal = 0; // Set by the signal handler only
+static unsigned char *branch_state = NULL;   // Per depth: 0 in first branch, 1 in second branch
+static int *decision_path = NULL;            // Per depth: decided literal (-x or x)
+static unsigned char *decision_phase = NULL; // Per variable: value of the first branch, all false if NULL
+static PerfCounters perf;
+static Trace trace;
+static Proof proof;
+static Symmetry symmetry = {false, 5000000ull, 0, 1000, 100, false, 0, 0, 0};
+static Bva bva = {false, 10000000ull, 0, false, 0, 0, 0, INT_MAX};
+static Lucky lucky = {true, 0, -1};
+static Simulation simulation = {false, 1, 10000000ull, 0, false, 0, 0, -1, -1};
+static Probing probing = {false, 10000000ull, 0, false, 0, 0, 0, 0, 0};
+static Elimination elimination = {false, 10000000ull, 0, false, 32, 16, 0, 0, 0, {0}, NULL, NULL};
+static const char *gate_names[NUM_GATE_TYPES] = {"AND", "XOR", "ITE"};
+static Backbone backbone = {false, 16, NULL, 0, 0, 0, 0, 0};
+static Heuristic heuristic = HEURISTIC_OCCURRENCE;
+static Communities communities = {0, 0, 0.0};
+static ResultCache cache = {NULL, "", 0, "off"};
+static Checkpointing checkpointing = {NULL, 60.0, 0.0, false, 0, 0, 0, NULL, 0, false, false, 0, 0, 0, 0.0};
 
 // DPLL
 
 DPLLReturnType dpll(Formula *formula, int *assignments, UndoStack *stack, WatchTable *wtable, int depth);
 bool unit_propagate_dpll(Formula *formula, int *assignments, UndoStack *stack);
 bool unit_propagate_2watchlit(Formula *formula, int *assignments, UndoStack *stack, WatchTable *wtable);
+bool queue_unit_clauses(Formula *formula, int *assignments, GQueue *queue);
 bool pure_literal_elimination(Formula *formula, int *assignments, UndoStack *stack);
 int pick_unassigned_variable(Formula *formula, int *assignments);
 
@@ -79,24 +726,173 @@ void push_clause_satisfy(UndoStack *stack, int index);
 void undo_to_checkpoint(UndoStack *stack, GSList *checkpoint, Formula *formula, int *assignments, WatchTable *wtable);
 
 WatchTable *init_empty_watch_table(Formula *formula);
+WatchTable *build_watch_table(Formula *formula);
 void watchtable_remove(WatchTable *wtable, int index, int value, UndoStack *stack);
 void watchtable_add(WatchTable *wtable, int index, int value, UndoStack *stack);
 void free_watchtable(WatchTable *wtable);
 void satisfy_clauses_after_assignment(Formula *formula, int *assignments, UndoStack *stack);
 
 Formula *parse_formula(const char *filename);
+void remove_duplicate_literals(Clause *clause);
 void free_formula(Formula *formula);
 
+SymGraph *build_symmetry_graph(Formula *formula);
+void free_symmetry_graph(SymGraph *graph);
+int sym_lit_node(Literal lit);
+GPtrArray *find_symmetry_generators(const SymGraph *graph);
+void add_clause(Formula *formula, int *capacity, const int *lits, int size);
+void add_symmetry_breaking(Formula *formula, const int *order);
+void bounded_variable_addition(Formula *formula);
+bool lucky_phases(Formula *formula, int *assignments, UndoStack *stack);
+bool simulate_assignments(Formula *formula, int *assignments, UndoStack *stack);
+int run_batch(char **paths, int count, bool show_model);
+void probe_failed_literals(Formula *formula);
+void eliminate_variables(Formula *formula);
+void reconstruct_model(int *assignments);
+void free_elimination();
+void defer_defined_variables(int *order, int numVars, int numVarsOriginal);
+
+WeightedGraph *build_variable_graph(Formula *formula);
+void free_weighted_graph(WeightedGraph *graph);
+int louvain_local_moves(const WeightedGraph *graph, int *community);
+WeightedGraph *aggregate_graph(const WeightedGraph *graph, const int *community, int numCommunities);
+WeightedGraph *detect_communities(const WeightedGraph *graph, int *membership);
+int *community_order(Formula *formula);
+
+void extract_features(Formula *formula, double *features);
+void print_features(const double *features);
+int find_preset(const char *name);
+void apply_preset(int index);
+SelectorModel *load_selector_model(const char *path);
+void selector_standardize(SelectorModel *model);
+int select_preset(const SelectorModel *model, const double *features, int exclude, bool allow_symmetry);
+void free_selector_model(SelectorModel *model);
+
+void formula_hash(Formula *formula);
+bool cache_lookup(Formula *formula, int *assignments, DPLLReturnType *result);
+void cache_store(DPLLReturnType result, const int *assignments, int numVars);
+bool write_checkpoint();
+bool load_checkpoint(const char *path, Formula *formula);
+void checkpoint_capture();
+
+void watch_clause(WatchTable *wtable, Formula *formula, int index);
+void remove_last_clause(Formula *formula, WatchTable *wtable);
+DPLLReturnType compute_backbone(Formula *formula, int *assignments, UndoStack *stack, WatchTable *wtable, int numVars);
+void print_backbone();
+
 gint lit_key(Literal *lit);
 gboolean clause_subset(Clause *a, Clause *b);
 void remove_supersets(Formula *formula);
 
-// Method to check if the timeout is triggered
-bool timeout_exceeded()
+double wall_seconds();
+double timer_start();
+void timer_stop(TimerType timer, double start);
+void print_stats(double elapsed_wall);
+void report_progress(double now);
+void perf_init();
+void perf_close();
+void perf_start(PerfSample *sample);
+void perf_stop(PerfPhase phase, const PerfSample *start);
+void print_perf_stats();
+bool trace_open(const char *filename);
+void trace_close();
+void trace_emit(TraceEventType type, int depth, int value);
+bool proof_open(const char *filename);
+void proof_close();
+void proof_unsat(int depth);
+void proof_add_clause(const int *lits, int size);
+void proof_delete_clause(const Clause *clause);
+void write_stats_json(const char *path, const RunInfo *info);
+bool verify_model(Formula *formula, int *assignments);
+void write_model(FILE *out, const int *assignments, int numVars);
+void print_model(int *assignments, int numVars);
+void print_partial_assignment(Formula *formula, int *assignments, int numVars);
+void handle_interrupt(int sig);
+void install_interrupt_handlers();
+
+// Only records the signal, which is async-signal-safe. The search sees it at its
+// next dpll call and unwinds through the normal exit path, so the result line,
+// statistics, trace, proof and checkpoint are all written. SA_RESETHAND restores
+// the default action: a second signal terminates at once.
+void handle_interrupt(int sig)
+{
+    interrupt_signal = sig;
+}
+
+void install_interrupt_handlers()
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_interrupt;
+    action.sa_flags = SA_RESETHAND | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+}
+
+// Method to check if any resource limit is triggered, records which one in limit_reached
+bool limit_exceeded()
 {
-    clock_t now = clock();
-    double elapsed = (double)(now - start_time) / CLOCKS_PER_SEC;
-    return elapsed >= timeout_seconds;
+    if (limit_reached != LIMIT_NONE)
+    {
+        return true;
+    }
+
+    if (interrupt_signal)
+    {
+        limit_reached = LIMIT_INTERRUPT;
+        return true;
+    }
+
+    if (limits.decisions && stats.decisions >= limits.decisions)
+    {
+        limit_reached = LIMIT_DECISIONS;
+    }
+    else if (limits.conflicts && stats.conflicts >= limits.conflicts)
+    {
+        limit_reached = LIMIT_CONFLICTS;
+    }
+    else if (limits.propagations && stats.propagations >= limits.propagations)
+    {
+        limit_reached = LIMIT_PROPAGATIONS;
+    }
+
+    if (limit_reached != LIMIT_NONE)
+    {
+        return true;
+    }
+
+    // Amortize the clock reads over check_interval calls
+    if (clock_check_countdown > 0)
+    {
+        clock_check_countdown--;
+        return false;
+    }
+    clock_check_countdown = limits.check_interval;
+
+    double now = wall_seconds();
+    if (limits.cpu_seconds > 0 && (double)(clock() - start_time) / CLOCKS_PER_SEC >= limits.cpu_seconds)
+    {
+        limit_reached = LIMIT_CPU;
+    }
+    else if (limits.wall_seconds > 0 && now - start_wall >= limits.wall_seconds)
+    {
+        limit_reached = LIMIT_WALL;
+    }
+
+    if (progress.interval > 0 && now >= progress.next_report)
+    {
+        report_progress(now);
+    }
+
+    if (checkpointing.path && checkpointing.active && !checkpointing.replaying && checkpointing.interval > 0 &&
+        now >= checkpointing.next_write)
+    {
+        write_checkpoint();
+        checkpointing.next_write = now + checkpointing.interval;
+    }
+
+    return limit_reached != LIMIT_NONE;
 }
 
 // Method to find the index of a lit in the watchlist
@@ -131,57 +927,9 @@ int *get_sorted_indices(int *counter, int numVars)
     return indices;
 }
 
-int main(int argc, char *argv[])
+// Decision order: variables by number of occurrences, most frequent first
+int *occurrence_order(Formula *formula)
 {
-    start_time = clock();
-
-    // Invalid argument case
-    if (argc != 2)
-    {
-        printf("Usage: %s <filename.cnf>\n", argv[0]);
-        return 1;
-    }
-
-    char *filename = argv[1];
-    printf("Filename provided: %s\n", filename);
-
-    Formula *formula = parse_formula(filename);
-    if (formula == NULL)
-    {
-        printf("File failed to parse!\n");
-        return 1;
-    }
-
-    // Remove superset clauses
-    remove_supersets(formula);
-
-    // Initialise WatchTable
-    WatchTable *wtable = init_empty_watch_table(formula);
-    for (int i = 0; i < formula->numClauses; i++)
-    {
-        Clause clause = formula->clauses[i];
-        if (clause.size == 0)
-        {
-            continue;
-        }
-        else if (clause.size == 1)
-        {
-            int index = watchlist_index(clause.literals[0], formula->numVars);
-            GArray *arr = wtable->watch_lists[index];
-            g_array_append_val(arr, i);
-        }
-        else
-        {
-            int index1 = watchlist_index(clause.literals[0], formula->numVars);
-            int index2 = watchlist_index(clause.literals[1], formula->numVars);
-            GArray *arr1 = wtable->watch_lists[index1];
-            GArray *arr2 = wtable->watch_lists[index2];
-            g_array_append_val(arr1, i);
-            g_array_append_val(arr2, i);
-        }
-    }
-
-    // Create sorted list of variable occurances for use in heuristic
     int *counter = calloc(formula->numVars + 1, sizeof(int));
     for (int i = 0; i < formula->numClauses; i++)
     {
@@ -192,851 +940,6551 @@ int main(int argc, char *argv[])
             counter[lit.var]++;
         }
     }
-    var_sort = get_sorted_indices(counter, formula->numVars);
+
+    int *order = get_sorted_indices(counter, formula->numVars);
     free(counter);
+    return order;
+}
 
-    // Init assignments array to all unassigned
-    int *assignments = (int *)malloc(sizeof(int) * (formula->numVars + 1));
-    for (int i = 1; i < formula->numVars + 1; i++)
+// Decision order of the selected heuristic
+int *decision_order(Formula *formula)
+{
+    if (heuristic == HEURISTIC_COMMUNITY)
     {
-        assignments[i] = -1;
+        return community_order(formula);
     }
+    return occurrence_order(formula);
+}
 
-    // Init UndoStack
-    UndoStack *undo_stack = malloc(sizeof(UndoStack));
-    undo_stack->head = NULL;
-
-    // Run SAT solver
-    DPLLReturnType sat = dpll(formula, assignments, undo_stack, wtable, 0);
+bool parse_heuristic(const char *name, Heuristic *out)
+{
+    for (int i = 0; i < NUM_HEURISTICS; i++)
+    {
+        if (strcmp(name, heuristic_names[i]) == 0)
+        {
+            *out = (Heuristic)i;
+            return true;
+        }
+    }
+    return false;
+}
 
-    // Free Memory
-    free(var_sort);
-    free(assignments);
-    g_slist_free_full(undo_stack->head, free);
-    free(undo_stack);
-    free_watchtable(wtable);
-    free_formula(formula);
+// Move the deferred variables behind all others in a decision order, keeping
+// the relative order within both groups
+void defer_variables(int *order, const bool *deferred)
+{
+    int end = 0;
+    while (order[end] != 0)
+    {
+        end++;
+    }
 
-    clock_t end_ticks = clock();
+    int *moved = malloc(sizeof(int) * (end + 1));
+    int kept = 0, numDeferred = 0;
+    for (int i = 0; i < end; i++)
+    {
+        if (deferred[order[i]])
+            moved[numDeferred++] = order[i];
+        else
+            order[kept++] = order[i];
+    }
+    memcpy(&order[kept], moved, sizeof(int) * numDeferred);
+    free(moved);
+}
 
-    if (sat == SAT)
+// Extend a decision order with the variables numbered after oldNumVars, placed
+// after all existing ones (before the 0 terminator)
+int *append_variables(int *order, int oldNumVars, int newNumVars)
+{
+    if (newNumVars == oldNumVars)
     {
-        printf("Result: SAT\n");
+        return order;
     }
-    else if (sat == UNSAT)
+
+    int end = 0;
+    while (end <= oldNumVars && order[end] != 0)
     {
-        printf("Result: UNSAT\n");
+        end++;
     }
-    else if (sat == TIMEOUT)
+
+    int added = newNumVars - oldNumVars;
+    order = realloc(order, sizeof(int) * (newNumVars + 1));
+    memmove(&order[end + added], &order[end], sizeof(int) * (oldNumVars + 1 - end));
+    for (int i = 0; i < added; i++)
     {
-        printf("Result: TIMEOUT\n");
+        order[end + i] = oldNumVars + 1 + i;
     }
+    return order;
+}
 
-    double elapsed_time = (double)(end_ticks - start_time) / CLOCKS_PER_SEC;
-    printf("CPU time used: %.5f seconds\n", elapsed_time);
-    return 0;
+// Monotonic wall clock in seconds
+double wall_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
-DPLLReturnType dpll(Formula *formula, int *assignments, UndoStack *undo_stack, WatchTable *wtable, int depth)
+double timer_start()
+{
+    return wall_seconds();
+}
+
+void timer_stop(TimerType timer, double start)
+{
+    stats.timers[timer] += wall_seconds() - start;
+}
+
+#ifdef __linux__
+int perf_open_event(unsigned long long config, int group_fd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+void perf_init()
 {
-    // Timeout Case
-    if (timeout_exceeded())
+    perf.enabled = false;
+    perf.leader = -1;
+    perf.num_open = 0;
+    for (int i = 0; i < NUM_PERF_EVENTS; i++)
     {
-        return TIMEOUT;
+        perf.fds[i] = -1;
+        perf.slot[i] = -1;
     }
 
-    // Undo Checkpoint
-    GSList *checkpoint = undo_stack->head;
+#ifdef __linux__
+    const unsigned long long configs[NUM_PERF_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
 
-    if (!unit_propagate_2watchlit(formula, assignments, undo_stack, wtable))
+    for (int i = 0; i < NUM_PERF_EVENTS; i++)
     {
-        undo_to_checkpoint(undo_stack, checkpoint, formula, assignments, wtable);
-        return UNSAT;
+        int fd = perf_open_event(configs[i], perf.leader);
+        if (fd < 0)
+        {
+            if (perf.leader < 0)
+            {
+                snprintf(perf.error, sizeof(perf.error), "perf_event_open: %s", strerror(errno));
+            }
+            continue;
+        }
+
+        // The first event that opens becomes the group leader
+        if (perf.leader < 0)
+        {
+            perf.leader = fd;
+        }
+        perf.fds[i] = fd;
+        perf.slot[i] = perf.num_open++;
     }
 
-    if (!pure_literal_elimination(formula, assignments, undo_stack))
+    if (perf.leader >= 0)
     {
-        undo_to_checkpoint(undo_stack, checkpoint, formula, assignments, wtable);
-        return UNSAT;
+        ioctl(perf.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(perf.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        perf.enabled = true;
     }
+#else
+    snprintf(perf.error, sizeof(perf.error), "not supported on this platform");
+#endif
+}
 
-    // Check if all clauses are satisfied.
-    // Extra check for any clauses that might have been satisified, without a flag
-    bool all_satisfied = true;
-    for (int i = 0; i < formula->numClauses; i++)
+void perf_close()
+{
+    for (int i = 0; i < NUM_PERF_EVENTS; i++)
     {
-        if (!formula->clauses[i].satisfied)
+        if (perf.fds[i] >= 0)
         {
-            bool missing_flag = false;
-            for (int j = 0; j < formula->clauses[i].size; j++)
-            {
-                Literal lit = formula->clauses[i].literals[j];
-                int as = assignments[lit.var];
-                if ((as == 0 && lit.neg) || (as == 1 && !lit.neg))
-                {
-                    missing_flag = true;
-                    break;
-                }
-            }
-
-            if (missing_flag)
-            {
-                formula->clauses[i].satisfied = true;
-                push_clause_satisfy(undo_stack, i);
-            }
-            else
-            {
-                all_satisfied = false;
-                break;
-            }
+            close(perf.fds[i]);
+            perf.fds[i] = -1;
         }
     }
+    perf.leader = -1;
+    perf.enabled = false;
+}
 
-    if (all_satisfied)
+void perf_start(PerfSample *sample)
+{
+    if (!perf.enabled)
     {
-        return SAT;
+        return;
     }
 
-    int x = pick_unassigned_variable(formula, assignments);
-    if (x == -1)
+    // Group read layout: nr, then one value per opened event
+    unsigned long long buffer[1 + NUM_PERF_EVENTS];
+    if (read(perf.leader, buffer, sizeof(buffer)) < (ssize_t)(sizeof(unsigned long long) * (1 + perf.num_open)))
     {
-        return UNSAT;
+        perf.enabled = false;
+        snprintf(perf.error, sizeof(perf.error), "group read failed");
+        return;
     }
-    else
+
+    for (int i = 0; i < NUM_PERF_EVENTS; i++)
     {
-        // Create a second checkpoint to undo the assignment + clause satisfy actions if needed.
-        GSList *checkpoint2 = undo_stack->head;
-        assignments[x] = 0;
-        push_assignment(undo_stack, x);
-        satisfy_clauses_after_assignment(formula, assignments, undo_stack);
+        sample->values[i] = perf.slot[i] >= 0 ? buffer[1 + perf.slot[i]] : 0;
+    }
+}
 
-        DPLLReturnType result1 = dpll(formula, assignments, undo_stack, wtable, depth + 1);
-        if (result1 == UNSAT)
-        {
-            // Second assignment case
-            undo_to_checkpoint(undo_stack, checkpoint2, formula, assignments, wtable);
-            assignments[x] = 1;
-            push_assignment(undo_stack, x);
-            satisfy_clauses_after_assignment(formula, assignments, undo_stack);
+void perf_stop(PerfPhase phase, const PerfSample *start)
+{
+    if (!perf.enabled)
+    {
+        return;
+    }
 
-            DPLLReturnType result2 = dpll(formula, assignments, undo_stack, wtable, depth + 1);
-            if (result2 == UNSAT)
-            {
-                undo_to_checkpoint(undo_stack, checkpoint, formula, assignments, wtable);
-            }
+    PerfSample end;
+    perf_start(&end);
+    if (!perf.enabled)
+    {
+        return;
+    }
 
-            return result2;
-        }
-        else
-        {
-            // Returns SAT or TIMEOUT
-            return result1;
-        }
+    for (int i = 0; i < NUM_PERF_EVENTS; i++)
+    {
+        perf.totals[phase][i] += end.values[i] - start->values[i];
     }
+    perf.calls[phase]++;
 }
 
-bool unit_propagate_dpll(Formula *formula, int *assignments, UndoStack *stack)
+void print_perf_stats()
 {
-    bool progress = true;
+    if (!perf.requested)
+    {
+        return;
+    }
 
-    while (progress)
+    if (perf.num_open == 0)
     {
-        progress = false;
+        printf("Perf counters: unavailable (%s)\n", perf.error);
+        return;
+    }
 
-        for (int i = 0; i < formula->numClauses; i++)
+    printf("Perf counters:%s\n", perf.enabled ? "" : " (stopped early)");
+    printf("  %-12s %12s %16s %16s %6s %14s %14s\n", "phase", "calls", "cycles", "instructions", "IPC", "cache_misses", "branch_misses");
+    for (int p = 0; p < NUM_PERF_PHASES; p++)
+    {
+        unsigned long long *t = perf.totals[p];
+        double ipc = t[PERF_CYCLES] ? (double)t[PERF_INSTRUCTIONS] / t[PERF_CYCLES] : 0.0;
+        printf("  %-12s %12llu", perf_phase_names[p], perf.calls[p]);
+        for (int e = 0; e < NUM_PERF_EVENTS; e++)
         {
-            if (formula->clauses[i].satisfied)
-            {
-                continue;
-            }
-
-            Clause clause = formula->clauses[i];
-
-            int unassigned_count = 0;
-            Literal unassigned_lit;
-            bool clause_satisfied = false;
-
-            for (int j = 0; j < clause.size; j++)
+            if (e == PERF_CACHE_MISSES)
             {
-                Literal lit = clause.literals[j];
-                int value = assignments[lit.var];
-
-                if (value == -1)
-                {
-                    unassigned_count++;
-                    unassigned_lit = lit;
-                }
+                if (perf.slot[PERF_CYCLES] >= 0 && perf.slot[PERF_INSTRUCTIONS] >= 0)
+                    printf(" %6.2f", ipc);
                 else
-                {
-                    if ((value == 1 && !lit.neg) || (value == 0 && lit.neg))
-                    {
-                        clause_satisfied = true;
-                        break;
-                    }
-                }
-            }
-
-            if (clause_satisfied)
-            {
-                continue;
-            }
-
-            if (unassigned_count == 0)
-            {
-                return false;
+                    printf(" %6s", "n/a");
             }
-            else if (unassigned_count == 1)
-            {
-                assignments[unassigned_lit.var] = (int)!unassigned_lit.neg;
-                push_assignment(stack, unassigned_lit.var);
 
-                progress = true;
-            }
+            if (perf.slot[e] >= 0)
+                printf(e < PERF_CACHE_MISSES ? " %16llu" : " %14llu", t[e]);
+            else
+                printf(e < PERF_CACHE_MISSES ? " %16s" : " %14s", "n/a");
         }
+        printf("\n");
     }
-
-    return true;
 }
 
-bool unit_propagate_2watchlit(Formula *formula, int *assignments, UndoStack *stack, WatchTable *wtable)
+void trace_drain()
 {
-    // Init a new queue for storing unit literals
-    GQueue *queue = g_queue_new();
+    size_t tail = atomic_load_explicit(&trace.tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&trace.head, memory_order_acquire);
 
-    // Here we add the literals from any unit clauses into the queue
-    for (int i = 0; i < formula->numClauses; i++)
+    while (tail != head)
     {
-        Clause *clause = &formula->clauses[i];
-        if (clause->satisfied)
+        size_t start = tail & (TRACE_RING_SIZE - 1);
+        size_t count = head - tail;
+        if (start + count > TRACE_RING_SIZE)
         {
-            continue;
+            count = TRACE_RING_SIZE - start;
         }
 
-        int unassigned_counter = 0;
-        Literal *lit_copy = malloc(sizeof(Literal));
-        for (int j = 0; j < clause->size; j++)
-        {
-            Literal lit = clause->literals[j];
-            if (assignments[lit.var] == -1)
-            {
-                if (unassigned_counter == 0)
-                {
-                    lit_copy->var = lit.var;
-                    lit_copy->neg = lit.neg;
-                }
-                unassigned_counter++;
-            }
-        }
+        fwrite(&trace.ring[start], sizeof(TraceRecord), count, trace.file);
+        tail += count;
+        atomic_store_explicit(&trace.tail, tail, memory_order_release);
+    }
+}
 
-        if (unassigned_counter == 1)
-        {
-            g_queue_push_tail(queue, lit_copy);
-        }
-        else
+void *trace_writer(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&trace.lock);
+    while (!atomic_load(&trace.stop))
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += 10 * 1000000;
+        if (deadline.tv_nsec >= 1000000000)
         {
-            free(lit_copy);
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
         }
+        pthread_cond_timedwait(&trace.wake, &trace.lock, &deadline);
+
+        pthread_mutex_unlock(&trace.lock);
+        trace_drain();
+        pthread_mutex_lock(&trace.lock);
     }
+    pthread_mutex_unlock(&trace.lock);
 
-    while (!g_queue_is_empty(queue))
+    trace_drain();
+    return NULL;
+}
+
+bool trace_open(const char *filename)
+{
+    trace.file = fopen(filename, "wb");
+    if (!trace.file)
     {
-        // Get the next literal. If it is unassigned, give it an assignment that satisfies it.
-        Literal *lit = g_queue_pop_head(queue);
+        return false;
+    }
 
-        if (assignments[lit->var] == -1)
-        {
-            // If literal is negated, set to false, else to true
-            assignments[lit->var] = lit->neg ? 0 : 1;
-            push_assignment(stack, lit->var);
+    uint32_t header[2] = {TRACE_VERSION, sizeof(TraceRecord)};
+    fwrite(TRACE_MAGIC, 1, 8, trace.file);
+    fwrite(header, sizeof(uint32_t), 2, trace.file);
 
-            int index = watchlist_index(*lit, formula->numVars);
-            GArray *wlist = wtable->watch_lists[index];
-            for (int i = 0; i < wlist->len; i++)
-            {
-                int indexc = g_array_index(wlist, int, i);
-                Clause *clause = &formula->clauses[indexc];
-                if (!clause->satisfied)
-                {
-                    clause->satisfied = true;
-                    push_clause_satisfy(stack, indexc);
-                }
-            }
-        }
+    trace.ring = malloc(sizeof(TraceRecord) * TRACE_RING_SIZE);
+    atomic_init(&trace.head, 0);
+    atomic_init(&trace.tail, 0);
+    atomic_init(&trace.stop, false);
+    pthread_mutex_init(&trace.lock, NULL);
+    pthread_cond_init(&trace.wake, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &trace.start);
 
-        // Find the opposite literal.
-        Literal oplit = {lit->var, !lit->neg};
-        int index = watchlist_index(oplit, formula->numVars);
-        GArray *wlist = wtable->watch_lists[index];
-        free(lit);
+    if (pthread_create(&trace.writer, NULL, trace_writer, NULL) != 0)
+    {
+        fclose(trace.file);
+        free(trace.ring);
+        return false;
+    }
 
-        // For each clause that watches the opposite literal
-        for (int i = 0; i < wlist->len; i++)
-        {
-            int indexi = g_array_index(wlist, int, i);
-            Clause *clause = &formula->clauses[indexi];
+    trace.enabled = true;
+    return true;
+}
 
-            if (clause->satisfied)
-            {
-                continue;
-            }
+void trace_close()
+{
+    if (!trace.enabled)
+    {
+        return;
+    }
 
-            // Find the other literal watched by this clause
-            Literal other = {0, false}; // 0 cannot be an actual literal.
-            for (int j = 0; j < clause->size; j++)
-            {
-                Literal l = clause->literals[j];
-                int indexj = watchlist_index(l, formula->numVars);
+    pthread_mutex_lock(&trace.lock);
+    atomic_store(&trace.stop, true);
+    pthread_cond_signal(&trace.wake);
+    pthread_mutex_unlock(&trace.lock);
+    pthread_join(trace.writer, NULL);
+
+    fclose(trace.file);
+    free(trace.ring);
+    pthread_mutex_destroy(&trace.lock);
+    pthread_cond_destroy(&trace.wake);
+    trace.enabled = false;
+}
 
-                // Is the literal we are looking at the opposite literal?
-                if (l.var == oplit.var && l.neg == oplit.neg)
-                {
-                    continue;
-                }
+void trace_emit(TraceEventType type, int depth, int value)
+{
+    if (!trace.enabled)
+    {
+        return;
+    }
 
-                // In the watch list of the next literal, check if this clause is watching it.
-                GArray *twlist = wtable->watch_lists[indexj];
-                for (int k = 0; k < twlist->len; k++)
-                {
-                    if (g_array_index(twlist, int, k) == indexi)
-                    {
-                        other = l;
-                        break;
-                    }
-                }
+    size_t head = atomic_load_explicit(&trace.head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&trace.tail, memory_order_acquire);
 
-                // If we found the other watch, exit loop
-                if (other.var != 0)
-                {
-                    break;
-                }
-            }
+    // Ring full: wake the writer and wait, records are never dropped
+    if (head - tail >= TRACE_RING_SIZE)
+    {
+        trace.stalls++;
+        while (head - atomic_load_explicit(&trace.tail, memory_order_acquire) >= TRACE_RING_SIZE)
+        {
+            pthread_mutex_lock(&trace.lock);
+            pthread_cond_signal(&trace.wake);
+            pthread_mutex_unlock(&trace.lock);
+            sched_yield();
+        }
+    }
 
-            // If there is no other literal being watched, eg. unit clause
-            if (other.var == 0)
-            {
-                // Skip if already satisfied
-                if (clause->satisfied)
-                {
-                    continue;
-                }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
 
-                // Otherwise, check if it is an unsatisfiable clause based on current assignments
-                bool all_false = true;
-                for (int x = 0; x < clause->size; x++)
-                {
-                    Literal tlit = clause->literals[x];
-                    int assign = assignments[tlit.var];
-                    all_false = all_false && ((assign == 0 && !tlit.neg) || (assign == 1 && tlit.neg));
-                }
+    TraceRecord *record = &trace.ring[head & (TRACE_RING_SIZE - 1)];
+    record->time_ns = (uint64_t)(now.tv_sec - trace.start.tv_sec) * 1000000000ull + now.tv_nsec - trace.start.tv_nsec;
+    record->value = value;
+    record->type_depth = (uint32_t)type | ((uint32_t)depth << 8);
+    atomic_store_explicit(&trace.head, head + 1, memory_order_release);
+    trace.records++;
 
-                if (all_false)
-                {
-                    g_queue_free_full(queue, free);
+    // Nudge the writer once half the ring is in use
+    if (head + 1 - tail == TRACE_RING_SIZE / 2)
+    {
+        pthread_mutex_lock(&trace.lock);
+        pthread_cond_signal(&trace.wake);
+        pthread_mutex_unlock(&trace.lock);
+    }
+}
+
+bool proof_open(const char *filename)
+{
+    proof.file = fopen(filename, "w");
+    if (!proof.file)
+    {
+        return false;
+    }
+
+    // Proofs of hard instances are large, write them in big blocks
+    setvbuf(proof.file, NULL, _IOFBF, 1 << 20);
+    return true;
+}
+
+void proof_close()
+{
+    if (proof.file)
+    {
+        fclose(proof.file);
+        proof.file = NULL;
+    }
+}
+
+// Negated decision literals of depths [0, depth), optionally followed by lit
+void proof_write_path(int depth, int lit)
+{
+    for (int level = 0; level < depth; level++)
+    {
+        fprintf(proof.file, "%d ", -decision_path[level]);
+    }
+    if (lit != 0)
+    {
+        fprintf(proof.file, "%d ", lit);
+    }
+    fputs("0\n", proof.file);
+}
+
+void proof_unsat(int depth)
+{
+    if (!proof.file)
+    {
+        return;
+    }
+
+    proof_write_path(depth, 0);
+    proof.added++;
+
+    // A node that failed after deciding at this depth owns the two child clauses
+    if (decision_path[depth] != 0)
+    {
+        int x = abs(decision_path[depth]);
+        fputs("d ", proof.file);
+        proof_write_path(depth, x);
+        fputs("d ", proof.file);
+        proof_write_path(depth, -x);
+        proof.deleted += 2;
+        decision_path[depth] = 0;
+    }
+}
+
+// Preprocessing steps: a resolvent is RUP, and deleting a clause is always allowed
+void proof_add_clause(const int *lits, int size)
+{
+    if (!proof.file)
+    {
+        return;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        fprintf(proof.file, "%d ", lits[i]);
+    }
+    fputs("0\n", proof.file);
+    proof.added++;
+}
+
+void proof_delete_clause(const Clause *clause)
+{
+    if (!proof.file)
+    {
+        return;
+    }
+
+    fputs("d ", proof.file);
+    for (int i = 0; i < clause->size; i++)
+    {
+        fprintf(proof.file, "%d ", clause->literals[i].neg ? -clause->literals[i].var : clause->literals[i].var);
+    }
+    fputs("0\n", proof.file);
+    proof.deleted++;
+}
+
+void json_string(FILE *out, const char *str)
+{
+    if (!str)
+    {
+        fputs("null", out);
+        return;
+    }
+
+    fputc('"', out);
+    for (const unsigned char *c = (const unsigned char *)str; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fprintf(out, "\\%c", *c);
+        else if (*c < 0x20)
+            fprintf(out, "\\u%04x", *c);
+        else
+            fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+// Append one JSON object (one line) with the configuration, counters, timers and
+// result of this run to path, or write it to stdout for "-"
+void write_stats_json(const char *path, const RunInfo *info)
+{
+    FILE *out = strcmp(path, "-") == 0 ? stdout : fopen(path, "a");
+    if (!out)
+    {
+        fprintf(stderr, "Cannot write stats to %s\n", path);
+        return;
+    }
+
+    fputs("{\"instance\":", out);
+    json_string(out, info->filename);
+    fputs(",\"result\":", out);
+    json_string(out, info->result);
+    fputs(",\"limit\":", out);
+    json_string(out, info->limit);
+    fprintf(out, ",\"exit_code\":%d,\"vars\":%d,\"clauses\":%d,\"clauses_preprocessed\":%d",
+            info->exit_code, info->numVars, info->numClauses, info->numClausesReduced);
+    fprintf(out, ",\"cpu_time\":%.6f,\"wall_time\":%.6f", info->cpu_time, info->wall_time);
+
+    fprintf(out, ",\"config\":{\"time_limit\":%g,\"cpu_limit\":%g,\"decision_limit\":%llu,\"conflict_limit\":%llu,"
+                 "\"propagation_limit\":%llu,\"check_interval\":%u,\"progress\":%g,\"perf\":%s,\"trace\":",
+            limits.wall_seconds, limits.cpu_seconds, limits.decisions, limits.conflicts, limits.propagations,
+            limits.check_interval, progress.interval, perf.requested ? "true" : "false");
+    json_string(out, info->trace_file);
+    fputs(",\"preset\":", out);
+    json_string(out, info->preset);
+    fprintf(out, ",\"heuristic\":\"%s\",\"lucky\":%s,\"simulate\":%s,\"symmetry\":%s,\"probe\":%s,\"bve\":%s,\"bva\":%s,"
+                 "\"backbone\":%s",
+            heuristic_names[heuristic], lucky.enabled ? "true" : "false", simulation.enabled ? "true" : "false",
+            symmetry.enabled ? "true" : "false", probing.enabled ? "true" : "false",
+            elimination.enabled ? "true" : "false", bva.enabled ? "true" : "false", backbone.enabled ? "true" : "false");
+    fputs(",\"features\":[", out);
+    bool first = true;
+    for (size_t i = 0; i < sizeof(build_features) / sizeof(build_features[0]); i++)
+    {
+        if (build_features[i].enabled)
+        {
+            fprintf(out, "%s\"%s\"", first ? "" : ",", build_features[i].name);
+            first = false;
+        }
+    }
+    fputs("]}", out);
+
+    fprintf(out, ",\"counters\":{\"decisions\":%llu,\"propagations\":%llu,\"conflicts\":%llu,\"watch_visits\":%llu,"
+                 "\"undo_entries\":%llu,\"restarts\":%llu,\"learned_clauses\":%llu}",
+            stats.decisions, stats.propagations, stats.conflicts, stats.watch_visits, stats.undo_entries,
+            stats.restarts, stats.learned_clauses);
+
+    fputs(",\"timers\":{", out);
+    for (int i = 0; i < NUM_TIMERS; i++)
+    {
+        fprintf(out, "%s\"%s\":%.6f", i ? "," : "", timer_names[i], stats.timers[i]);
+    }
+    fputc('}', out);
+
+    if (lucky.enabled)
+    {
+        fprintf(out, ",\"lucky\":{\"tried\":%d,\"phase\":", lucky.tried);
+        json_string(out, lucky.phase >= 0 ? lucky_names[lucky.phase] : NULL);
+        fputc('}', out);
+    }
+
+    if (simulation.enabled)
+    {
+        fprintf(out, ",\"simulate\":{\"rounds\":%d,\"flips\":%llu,\"initial_unsat\":%d,\"best_unsat\":%d,\"steps\":%llu,"
+                     "\"exhausted\":%s}",
+                simulation.rounds, simulation.flips, simulation.initial_unsat, simulation.best_unsat, simulation.steps,
+                simulation.exhausted ? "true" : "false");
+    }
+
+    if (probing.enabled)
+    {
+        fprintf(out, ",\"probe\":{\"rounds\":%d,\"probed\":%d,\"failed\":%d,\"hyper_binary\":%d,\"reduced\":%d,"
+                     "\"steps\":%llu,\"exhausted\":%s}",
+                probing.rounds, probing.probed, probing.failed, probing.hyper_binary, probing.reduced, probing.steps,
+                probing.exhausted ? "true" : "false");
+    }
+
+    if (elimination.enabled)
+    {
+        fprintf(out, ",\"bve\":{\"eliminated\":%d,\"and\":%d,\"xor\":%d,\"ite\":%d,\"gates\":%u,\"clauses_removed\":%d,"
+                     "\"clauses_added\":%d,\"steps\":%llu,\"exhausted\":%s",
+                elimination.eliminated, elimination.definitions[GATE_AND], elimination.definitions[GATE_XOR],
+                elimination.definitions[GATE_ITE], elimination.gates ? elimination.gates->len : 0,
+                elimination.clauses_removed, elimination.clauses_added, elimination.steps,
+                elimination.exhausted ? "true" : "false");
+        // Every recognized gate, as output literal, type and input literals
+        fputs(",\"gate_list\":[", out);
+        for (guint g = 0; elimination.gates && g < elimination.gates->len; g++)
+        {
+            Gate *gate = &g_array_index(elimination.gates, Gate, g);
+            fprintf(out, "%s{\"type\":\"%s\",\"output\":%d,\"inputs\":[", g ? "," : "", gate_names[gate->type],
+                    gate->output);
+            for (int i = 0; i < gate->numInputs; i++)
+            {
+                fprintf(out, "%s%d", i ? "," : "", gate->inputs[i]);
+            }
+            fprintf(out, "],\"eliminated\":%s}", gate->eliminated ? "true" : "false");
+        }
+        fputs("]}", out);
+    }
+
+    if (bva.enabled)
+    {
+        fprintf(out, ",\"bva\":{\"vars_added\":%d,\"clauses_removed\":%d,\"clauses_added\":%d,\"steps\":%llu,\"exhausted\":%s}",
+                bva.vars_added, bva.clauses_removed, bva.clauses_added, bva.steps, bva.exhausted ? "true" : "false");
+    }
+
+    if (symmetry.enabled)
+    {
+        fprintf(out, ",\"symmetry\":{\"generators\":%d,\"clauses\":%d,\"aux_vars\":%d,\"steps\":%llu,\"exhausted\":%s}",
+                symmetry.generators, symmetry.clauses_added, symmetry.aux_vars, symmetry.steps,
+                symmetry.exhausted ? "true" : "false");
+    }
+
+    if (info->features)
+    {
+        fputs(",\"instance_features\":{", out);
+        for (int i = 0; i < NUM_FEATURES; i++)
+        {
+            fprintf(out, "%s\"%s\":%.6f", i ? "," : "", feature_names[i], info->features[i]);
+        }
+        fputc('}', out);
+    }
+
+    if (heuristic == HEURISTIC_COMMUNITY)
+    {
+        fprintf(out, ",\"communities\":{\"count\":%d,\"levels\":%d,\"modularity\":%.6f}", communities.count,
+                communities.levels, communities.modularity);
+    }
+
+    if (checkpointing.path || checkpointing.resume_path)
+    {
+        fprintf(out, ",\"checkpoint\":{\"written\":%d,\"resumed_depth\":%d,\"prior_decisions\":%llu,\"prior_seconds\":%.3f}",
+                checkpointing.written, checkpointing.resume_depth, checkpointing.prior_decisions,
+                checkpointing.prior_seconds);
+    }
+
+    if (cache.dir)
+    {
+        fprintf(out, ",\"cache\":{\"status\":\"%s\",\"key\":\"%s\"}", cache.status, cache.key);
+    }
+
+    if (backbone.enabled)
+    {
+        fprintf(out, ",\"backbone\":{\"size\":%d,\"candidates\":%d,\"queries\":%llu,\"sat_queries\":%llu,"
+                     "\"unsat_queries\":%llu}",
+                backbone.size, backbone.candidates, backbone.queries, backbone.sat_queries, backbone.unsat_queries);
+    }
+
+    if (perf.requested)
+    {
+        const char *event_names[NUM_PERF_EVENTS] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+        fputs(",\"perf\":", out);
+        if (perf.num_open == 0)
+        {
+            fputs("null", out);
+        }
+        else
+        {
+            fputc('{', out);
+            for (int p = 0; p < NUM_PERF_PHASES; p++)
+            {
+                fprintf(out, "%s\"%s\":{\"calls\":%llu", p ? "," : "", perf_phase_names[p], perf.calls[p]);
+                for (int e = 0; e < NUM_PERF_EVENTS; e++)
+                {
+                    if (perf.slot[e] >= 0)
+                        fprintf(out, ",\"%s\":%llu", event_names[e], perf.totals[p][e]);
+                }
+                fputc('}', out);
+            }
+            fputc('}', out);
+        }
+    }
+
+    fputs("}\n", out);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    else
+    {
+        fflush(out);
+    }
+}
+
+// Print counters with their rate over the whole run, followed by the phase timers
+void print_stats(double elapsed_wall)
+{
+#if SAT_STATS || SAT_TIMERS
+    double seconds = elapsed_wall > 0 ? elapsed_wall : 1e-9;
+#else
+    (void)elapsed_wall;
+#endif
+#if SAT_STATS
+    struct
+    {
+        const char *name;
+        unsigned long long value;
+    } counters[] = {
+        {"decisions", stats.decisions},
+        {"propagations", stats.propagations},
+        {"conflicts", stats.conflicts},
+        {"watch_visits", stats.watch_visits},
+        {"undo_entries", stats.undo_entries},
+        {"restarts", stats.restarts},
+        {"learned_clauses", stats.learned_clauses},
+    };
+
+    printf("Statistics:\n");
+    for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++)
+    {
+        printf("  %-18s %14llu  (%.1f/s)\n", counters[i].name, counters[i].value, counters[i].value / seconds);
+    }
+#else
+    printf("Statistics: not compiled into this build (SAT_STATS=0)\n");
+#endif
+
+#if SAT_TIMERS
+    printf("Timers:\n");
+    for (int i = 0; i < NUM_TIMERS; i++)
+    {
+        printf("  %-18s %14.5f s  (%5.1f%%)\n", timer_names[i], stats.timers[i], 100.0 * stats.timers[i] / seconds);
+    }
+#else
+    printf("Timers: not compiled into this build (SAT_TIMERS=0)\n");
+#endif
+}
+
+void print_usage(const char *prog)
+{
+    printf("Usage: %s [options] <filename.cnf>\n", prog);
+    printf("       %s --batch [--model] [--decision-limit N] [--time-limit SEC] [--cpu-limit SEC] <filename.cnf>...\n",
+           prog);
+    printf("  --time-limit SEC          Wall-clock limit (default none)\n");
+    printf("  --cpu-limit SEC           CPU time limit, 0 for none (default 3600)\n");
+    printf("  --decision-limit N        Stop after N decisions\n");
+    printf("  --conflict-limit N        Stop after N conflicts\n");
+    printf("  --propagation-limit N     Stop after N propagations\n");
+    printf("  --check-interval N        dpll calls between clock checks (default 256)\n");
+    printf("  --progress SEC            Print a progress line to stderr every SEC seconds\n");
+    printf("  --perf                    Report hardware counters per solver phase\n");
+    printf("  --trace FILE              Record a binary search trace (convert with sat_trace)\n");
+    printf("  --stats-json FILE         Append the run's statistics as one JSON line ('-' for stdout)\n");
+    printf("  --model                   Print the satisfying assignment as DIMACS v lines\n");
+    printf("  --proof FILE              Write a DRUP proof of unsatisfiability\n");
+    printf("  --symmetry                Add lex-leader symmetry-breaking clauses\n");
+    printf("  --symmetry-budget N       Refinement work for the symmetry search (default 5000000)\n");
+    printf("  --symmetry-chain N        Variables per lex-leader constraint, 0 for all (default 100)\n");
+    printf("  --symmetry-generators N   Stop after N generators, 0 for no limit (default 1000)\n");
+    printf("  --heuristic NAME          Decision order: occurrence (default) or community\n");
+    printf("  --config NAME             Preset: occurrence, community, symmetry or community-symmetry\n");
+    printf("  --features                Print the instance features used by --auto-config\n");
+    printf("  --auto-config MODEL       Pick the preset with a model trained by sat_selector\n");
+    printf("  --backbone                Print the literals true in every model as b lines\n");
+    printf("  --backbone-chunk N        Candidates per backbone query at the start (default 16)\n");
+    printf("  --cache DIR               Reuse and store results keyed by the canonical formula hash\n");
+    printf("  --no-lucky                Skip the all-false/all-true and greedy assignments tried before the search\n");
+    printf("  --simulate                Simulate 64 random assignments at once, a model or phases for the search\n");
+    printf("  --simulate-budget N       Clause literals evaluated by --simulate (default 10000000)\n");
+    printf("  --simulate-seed S         Seed of the simulated assignments (default 1)\n");
+    printf("  --probe                   Probe failed literals, adding hyper-binary resolvents\n");
+    printf("  --probe-budget N          Clause literals visited by --probe (default 10000000)\n");
+    printf("  --bve                     Eliminate variables by resolution, using AND/XOR/ITE definitions\n");
+    printf("  --bve-budget N            Clause literals visited by --bve (default 10000000)\n");
+    printf("  --bva                     Replace clause grids such as pairwise at-most-one by fresh variables\n");
+    printf("  --bva-budget N            Clause literals visited by --bva (default 10000000)\n");
+    printf("  --batch                   Solve many instances of at most 64 variables in one process, one line each\n");
+    printf("  --checkpoint FILE         Save the search position periodically and when a limit stops it\n");
+    printf("  --checkpoint-interval SEC Seconds between checkpoints, 0 for only at a limit (default 60)\n");
+    printf("  --resume FILE             Continue the search from a checkpoint, if FILE exists\n");
+    printf("Exit codes: 0 solved, 1 usage or parse error, 2 wall-clock, 3 CPU, 4 decision,\n");
+    printf("            5 conflict and 6 propagation limit reached, 130/143 interrupted by SIGINT/SIGTERM\n");
+    printf("Compiled features:");
+    for (size_t i = 0; i < sizeof(build_features) / sizeof(build_features[0]); i++)
+    {
+        printf(" %s%s", build_features[i].enabled ? "+" : "-", build_features[i].name);
+    }
+    printf("\n");
+}
+
+// Resident set size in KB from /proc, 0 if unavailable
+long current_rss_kb()
+{
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (!file)
+    {
+        return 0;
+    }
+
+    long size = 0, resident = 0;
+    if (fscanf(file, "%ld %ld", &size, &resident) != 2)
+    {
+        resident = 0;
+    }
+    fclose(file);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Knuth-style estimate of the unexplored part of the search tree. Every level on
+// the current path that is still in its first branch has an open sibling subtree,
+// estimated from the current path below it (branching factor 2 per level).
+// explored is the fraction of a balanced tree already closed by second branches.
+double estimate_remaining_nodes(int depth, double *explored)
+{
+    double remaining = 0.0;
+    *explored = 0.0;
+    for (int level = 0; level < depth; level++)
+    {
+        if (branch_state[level] == 0)
+        {
+            remaining += ldexp(1.0, depth - level) - 1.0;
+        }
+        else
+        {
+            *explored += ldexp(1.0, -(level + 1));
+        }
+    }
+
+    return remaining;
+}
+
+void report_progress(double now)
+{
+    double interval = now - progress.last_time;
+    if (interval <= 0)
+    {
+        interval = 1e-9;
+    }
+
+    double explored;
+    double remaining = estimate_remaining_nodes(search_depth, &explored);
+
+    fprintf(stderr, "c progress %9.1fs | %10.1f dec/s | %12.1f prop/s | depth %6d | trail %8d | rss %8.1f MB | remaining ~%.3g nodes | explored %6.2f%%\n",
+            now - start_wall,
+            (stats.decisions - progress.last_decisions) / interval,
+            (stats.propagations - progress.last_propagations) / interval,
+            search_depth, trail_size, current_rss_kb() / 1024.0, remaining, 100.0 * explored);
+    fflush(stderr);
+
+    progress.last_time = now;
+    progress.last_decisions = stats.decisions;
+    progress.last_propagations = stats.propagations;
+    progress.next_report = now + progress.interval;
+}
+
+// The test and benchmark tools include this file with SAT_SOLVER_NO_MAIN defined
+#ifndef SAT_SOLVER_NO_MAIN
+static const char *limit_names[NUM_LIMITS] = {
+    "none", "wall-clock time", "CPU time", "decisions", "conflicts", "propagations", "interrupt"};
+
+// Exit code per limit, so scripts can tell which budget ran out. An interrupt
+// exits with 128 + signal number, as a shell reports a process killed by it.
+static const int limit_exit_codes[NUM_LIMITS] = {0, 2, 3, 4, 5, 6, 128};
+
+// Result line, statistics and JSON record at the end of a run; returns the exit code
+int finish_run(DPLLReturnType sat, bool model_ok, RunInfo *info, const char *stats_json)
+{
+    clock_t end_ticks = clock();
+
+    if (sat == SAT && !model_ok)
+    {
+        printf("Result: ERROR (model verification failed)\n");
+    }
+    else if (sat == SAT)
+    {
+        printf("Result: SAT\n");
+    }
+    else if (sat == UNSAT)
+    {
+        printf("Result: UNSAT\n");
+    }
+    else if (sat == TIMEOUT && limit_reached == LIMIT_INTERRUPT)
+    {
+        printf("Result: INTERRUPTED (%s)\n", interrupt_signal == SIGINT ? "SIGINT" : "SIGTERM");
+    }
+    else if (sat == TIMEOUT)
+    {
+        printf("Result: TIMEOUT (%s limit)\n", limit_names[limit_reached]);
+    }
+
+    double elapsed_time = (double)(end_ticks - start_time) / CLOCKS_PER_SEC;
+    double elapsed_wall = wall_seconds() - start_wall;
+    print_stats(elapsed_wall);
+    print_perf_stats();
+    perf_close();
+    printf("CPU time used: %.5f seconds\n", elapsed_time);
+    printf("Wall time used: %.5f seconds\n", elapsed_wall);
+
+    bool interrupted = sat == TIMEOUT && limit_reached == LIMIT_INTERRUPT;
+    int exit_code = sat == TIMEOUT ? limit_exit_codes[limit_reached] : model_ok ? 0 : 1;
+    if (interrupted)
+    {
+        exit_code += interrupt_signal;
+    }
+    if (stats_json)
+    {
+        info->result = !model_ok ? "ERROR" : sat == SAT ? "SAT" : sat == UNSAT ? "UNSAT" : "TIMEOUT";
+        if (interrupted)
+        {
+            info->result = "INTERRUPTED";
+        }
+        info->limit = limit_names[limit_reached];
+        info->exit_code = exit_code;
+        info->cpu_time = elapsed_time;
+        info->wall_time = elapsed_wall;
+        write_stats_json(stats_json, info);
+    }
+
+    return exit_code;
+}
+
+int main(int argc, char *argv[])
+{
+    start_time = clock();
+    start_wall = wall_seconds();
+
+    static struct option long_options[] = {
+        {"time-limit", required_argument, 0, 'T'},
+        {"cpu-limit", required_argument, 0, 'C'},
+        {"decision-limit", required_argument, 0, 'D'},
+        {"conflict-limit", required_argument, 0, 'K'},
+        {"propagation-limit", required_argument, 0, 'P'},
+        {"check-interval", required_argument, 0, 'I'},
+        {"progress", required_argument, 0, 'R'},
+        {"perf", no_argument, 0, 'H'},
+        {"trace", required_argument, 0, 'X'},
+        {"stats-json", required_argument, 0, 'J'},
+        {"model", no_argument, 0, 'M'},
+        {"proof", required_argument, 0, 'Q'},
+        {"symmetry", no_argument, 0, 'S'},
+        {"symmetry-budget", required_argument, 0, 'B'},
+        {"symmetry-chain", required_argument, 0, 'L'},
+        {"symmetry-generators", required_argument, 0, 'G'},
+        {"heuristic", required_argument, 0, 'E'},
+        {"config", required_argument, 0, 'O'},
+        {"features", no_argument, 0, 'F'},
+        {"auto-config", required_argument, 0, 'A'},
+        {"backbone", no_argument, 0, 'b'},
+        {"backbone-chunk", required_argument, 0, 'k'},
+        {"cache", required_argument, 0, 'c'},
+        {"no-lucky", no_argument, 0, 'l'},
+        {"simulate", no_argument, 0, 'm'},
+        {"simulate-budget", required_argument, 0, 'n'},
+        {"simulate-seed", required_argument, 0, 'i'},
+        {"probe", no_argument, 0, 'p'},
+        {"probe-budget", required_argument, 0, 'q'},
+        {"bve", no_argument, 0, 'W'},
+        {"bve-budget", required_argument, 0, 'w'},
+        {"bva", no_argument, 0, 'Y'},
+        {"bva-budget", required_argument, 0, 'Z'},
+        {"batch", no_argument, 0, 'x'},
+        {"checkpoint", required_argument, 0, 'V'},
+        {"checkpoint-interval", required_argument, 0, 'N'},
+        {"resume", required_argument, 0, 'U'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}};
+
+    const char *trace_file = NULL;
+    const char *stats_json = NULL;
+    const char *proof_file = NULL;
+    const char *preset_name = NULL;
+    const char *selector_path = NULL;
+    const char *resume_file = NULL;
+    bool show_model = false;
+    bool show_features = false;
+    bool batch = false;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'T':
+            limits.wall_seconds = atof(optarg);
+            break;
+        case 'C':
+            limits.cpu_seconds = atof(optarg);
+            break;
+        case 'D':
+            limits.decisions = strtoull(optarg, NULL, 10);
+            break;
+        case 'K':
+            limits.conflicts = strtoull(optarg, NULL, 10);
+            break;
+        case 'P':
+            limits.propagations = strtoull(optarg, NULL, 10);
+            break;
+        case 'I':
+            limits.check_interval = (unsigned int)strtoul(optarg, NULL, 10);
+            break;
+        case 'R':
+            progress.interval = atof(optarg);
+            break;
+        case 'H':
+            perf.requested = true;
+            break;
+        case 'X':
+            trace_file = optarg;
+            break;
+        case 'J':
+            stats_json = optarg;
+            break;
+        case 'M':
+            show_model = true;
+            break;
+        case 'Q':
+            proof_file = optarg;
+            break;
+        case 'S':
+            symmetry.enabled = true;
+            break;
+        case 'B':
+            symmetry.budget = strtoull(optarg, NULL, 10);
+            break;
+        case 'L':
+            symmetry.max_chain = atoi(optarg);
+            break;
+        case 'G':
+            symmetry.max_generators = atoi(optarg);
+            break;
+        case 'E':
+            if (!parse_heuristic(optarg, &heuristic))
+            {
+                printf("Unknown heuristic: %s\n", optarg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'O':
+            if (find_preset(optarg) < 0)
+            {
+                printf("Unknown configuration: %s\n", optarg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            apply_preset(find_preset(optarg));
+            preset_name = optarg;
+            break;
+        case 'F':
+            show_features = true;
+            break;
+        case 'A':
+            selector_path = optarg;
+            break;
+        case 'b':
+            backbone.enabled = true;
+            break;
+        case 'k':
+            backbone.chunk = atoi(optarg);
+            break;
+        case 'c':
+            cache.dir = optarg;
+            break;
+        case 'l':
+            lucky.enabled = false;
+            break;
+        case 'm':
+            simulation.enabled = true;
+            break;
+        case 'n':
+            simulation.budget = strtoull(optarg, NULL, 10);
+            break;
+        case 'i':
+            simulation.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'p':
+            probing.enabled = true;
+            break;
+        case 'q':
+            probing.budget = strtoull(optarg, NULL, 10);
+            break;
+        case 'W':
+            elimination.enabled = true;
+            break;
+        case 'w':
+            elimination.budget = strtoull(optarg, NULL, 10);
+            break;
+        case 'Y':
+            bva.enabled = true;
+            break;
+        case 'Z':
+            bva.budget = strtoull(optarg, NULL, 10);
+            break;
+        case 'x':
+            batch = true;
+            break;
+        case 'V':
+            checkpointing.path = optarg;
+            break;
+        case 'N':
+            checkpointing.interval = atof(optarg);
+            break;
+        case 'U':
+            resume_file = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Invalid argument case
+    if (batch ? optind >= argc : optind != argc - 1)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (batch && (proof_file || trace_file || stats_json || checkpointing.path || resume_file || backbone.enabled ||
+                  cache.dir || selector_path || show_features))
+    {
+        printf("--batch runs a word-sized search per instance, it cannot be combined with --proof, --trace, "
+               "--stats-json, --checkpoint, --resume, --backbone, --cache, --auto-config or --features\n");
+        return 1;
+    }
+    if (batch && (limits.conflicts || limits.propagations || progress.interval > 0 || preset_name ||
+                  heuristic != HEURISTIC_OCCURRENCE || symmetry.enabled || probing.enabled || elimination.enabled ||
+                  bva.enabled || simulation.enabled))
+    {
+        printf("--batch has no preprocessing and counts only decisions, it cannot be combined with --conflict-limit, "
+               "--propagation-limit, --progress, --config, --heuristic, --symmetry, --probe, --bve, --bva or "
+               "--simulate\n");
+        return 1;
+    }
+
+    // Options that depend on features compiled out of this build
+    if (!SAT_STATS && (limits.decisions || limits.conflicts || limits.propagations))
+    {
+        printf("Counter limits need a build with SAT_STATS=1\n");
+        return 1;
+    }
+    if (!SAT_PROOF && proof_file)
+    {
+        printf("Proof logging needs a build with SAT_PROOF=1\n");
+        return 1;
+    }
+    if (proof_file && symmetry.enabled)
+    {
+        printf("Symmetry-breaking clauses are not implied by the formula, --proof cannot be combined with --symmetry\n");
+        return 1;
+    }
+    if (proof_file && bva.enabled)
+    {
+        printf("Clauses over the variables added by --bva are not RUP, --proof cannot be combined with --bva\n");
+        return 1;
+    }
+    if (backbone.enabled && (symmetry.enabled || proof_file))
+    {
+        printf("--backbone needs every model, it cannot be combined with --symmetry or --proof\n");
+        return 1;
+    }
+    if (backbone.enabled && elimination.enabled)
+    {
+        printf("Eliminated variables do not take part in the search, --backbone cannot be combined with --bve\n");
+        return 1;
+    }
+    if (resume_file && proof_file)
+    {
+        printf("A resumed search skips the subtrees refuted before the checkpoint, --proof cannot be combined with "
+               "--resume\n");
+        return 1;
+    }
+    if (checkpointing.interval < 0)
+    {
+        printf("--checkpoint-interval must not be negative\n");
+        return 1;
+    }
+    if (backbone.chunk < 1)
+    {
+        printf("--backbone-chunk must be at least 1\n");
+        return 1;
+    }
+    if (!SAT_TRACE && trace_file)
+    {
+        printf("Tracing is not compiled into this build (SAT_TRACE=0), ignoring --trace\n");
+        trace_file = NULL;
+    }
+
+    install_interrupt_handlers();
+    if (batch)
+    {
+        return run_batch(&argv[optind], argc - optind, show_model);
+    }
+
+    char *filename = argv[optind];
+    printf("Filename provided: %s\n", filename);
+    RunInfo info = {filename, "ERROR", limit_names[LIMIT_NONE], 1, 0, 0, 0, 0.0, 0.0, trace_file, preset_name, NULL};
+
+    if (perf.requested)
+    {
+#if SAT_PERF
+        perf_init();
+#else
+        snprintf(perf.error, sizeof(perf.error), "not compiled into this build (SAT_PERF=0)");
+#endif
+    }
+
+    double t = 0.0;
+    TIMER_START(t);
+    Formula *formula = parse_formula(filename);
+    TIMER_STOP(TIMER_PARSE, t);
+    if (formula == NULL)
+    {
+        printf("File failed to parse!\n");
+        if (stats_json)
+        {
+            info.wall_time = wall_seconds() - start_wall;
+            write_stats_json(stats_json, &info);
+        }
+        return 1;
+    }
+    info.numVars = formula->numVars;
+    info.numClauses = formula->numClauses;
+
+    // A cached answer for the same clause set ends the run here. Proofs and
+    // backbones need the search itself, those runs only store their result.
+    // The hash also identifies the formula of a checkpoint
+    if (checkpointing.path || resume_file)
+    {
+        formula_hash(formula);
+    }
+    if (cache.dir)
+    {
+        TIMER_START(t);
+        formula_hash(formula);
+        DPLLReturnType cached = TIMEOUT;
+        int *model = malloc(sizeof(int) * (formula->numVars + 1));
+        bool hit = !proof_file && !backbone.enabled && cache_lookup(formula, model, &cached);
+        if (proof_file || backbone.enabled)
+        {
+            cache.status = "bypass";
+        }
+        TIMER_STOP(TIMER_CACHE, t);
+        printf("Cache: %s %s\n", cache.status, cache.key);
+        if (hit)
+        {
+            if (cached == SAT && show_model)
+            {
+                print_model(model, formula->numVars);
+            }
+            info.numClausesReduced = formula->numClauses;
+            free(model);
+            free_formula(formula);
+            return finish_run(cached, true, &info, stats_json);
+        }
+        free(model);
+    }
+
+    // Features of the formula as parsed, and the preset they select
+    double features[NUM_FEATURES];
+    if (show_features || selector_path)
+    {
+        TIMER_START(t);
+        extract_features(formula, features);
+        TIMER_STOP(TIMER_FEATURES, t);
+        info.features = features;
+    }
+    if (show_features)
+    {
+        print_features(features);
+    }
+    if (selector_path)
+    {
+        SelectorModel *model = load_selector_model(selector_path);
+        if (!model)
+        {
+            printf("Cannot read selector model %s\n", selector_path);
+            free_formula(formula);
+            return 1;
+        }
+
+        // Symmetry breaking removes models, which --proof and --backbone need
+        int chosen = select_preset(model, features, -1, !proof_file && !backbone.enabled);
+        if (chosen >= 0)
+        {
+            apply_preset(chosen);
+            info.preset = presets[chosen].name;
+            printf("Auto-config: %s (%d nearest of %d training instances)\n", presets[chosen].name,
+                   model->count < SELECTOR_K ? model->count : SELECTOR_K, model->count);
+        }
+        else
+        {
+            printf("Auto-config: no usable training instances, keeping the configuration\n");
+        }
+        free_selector_model(model);
+    }
+
+    // Opened before preprocessing, which adds the resolvents of eliminated variables
+    if (proof_file && !proof_open(proof_file))
+    {
+        printf("Cannot write proof file %s\n", proof_file);
+    }
+
+    // Preprocessing: superset removal, watch table and variable order
+    PerfSample perf_sample;
+    PERF_START(perf_sample);
+
+    // Remove superset clauses
+    TIMER_START(t);
+    remove_supersets(formula);
+    TIMER_STOP(TIMER_SUPERSETS, t);
+
+    // Variables added by preprocessing are numbered after the original ones and
+    // decided after them; models are printed for the original variables only
+    int numVarsOriginal = formula->numVars;
+    if (probing.enabled)
+    {
+        int numClausesBefore = formula->numClauses;
+        TIMER_START(t);
+        probe_failed_literals(formula);
+        TIMER_STOP(TIMER_PROBE, t);
+        printf("Probing: %d literals in %d rounds, %d failed, %d hyper-binary resolvents added, %d binary clauses "
+               "reduced (%d -> %d clauses, %llu steps%s)\n",
+               probing.probed, probing.rounds, probing.failed, probing.hyper_binary, probing.reduced,
+               numClausesBefore, formula->numClauses, probing.steps, probing.exhausted ? ", budget exhausted" : "");
+    }
+    if (elimination.enabled)
+    {
+        int numClausesBefore = formula->numClauses;
+        TIMER_START(t);
+        eliminate_variables(formula);
+        TIMER_STOP(TIMER_BVE, t);
+        printf("BVE: %d variables eliminated (%d AND, %d XOR, %d ITE definitions), %d clauses replaced by %d (%d -> %d "
+               "clauses, %d gates recognized, %llu steps%s)\n",
+               elimination.eliminated, elimination.definitions[GATE_AND], elimination.definitions[GATE_XOR],
+               elimination.definitions[GATE_ITE], elimination.clauses_removed, elimination.clauses_added,
+               numClausesBefore, formula->numClauses, elimination.gates->len, elimination.steps,
+               elimination.exhausted ? ", budget exhausted" : "");
+    }
+    if (bva.enabled)
+    {
+        int numClausesBefore = formula->numClauses;
+        TIMER_START(t);
+        bounded_variable_addition(formula);
+        TIMER_STOP(TIMER_BVA, t);
+        printf("BVA: %d variables added, %d clauses replaced by %d (%d -> %d clauses, %llu steps%s)\n", bva.vars_added,
+               bva.clauses_removed, bva.clauses_added, numClausesBefore, formula->numClauses, bva.steps,
+               bva.exhausted ? ", budget exhausted" : "");
+    }
+
+    // Decision order for the heuristic
+    TIMER_START(t);
+    var_sort = decision_order(formula);
+    defer_defined_variables(var_sort, formula->numVars, numVarsOriginal);
+    TIMER_STOP(TIMER_ORDER, t);
+    if (heuristic == HEURISTIC_COMMUNITY)
+    {
+        printf("Communities: %d (modularity %.3f, %d levels)\n", communities.count, communities.modularity,
+               communities.levels);
+    }
+
+    // Symmetry-breaking clauses use the decision order as lex order, their
+    // auxiliary variables are numbered and decided after all others
+    if (symmetry.enabled)
+    {
+        int numVarsBefore = formula->numVars;
+        TIMER_START(t);
+        add_symmetry_breaking(formula, var_sort);
+        var_sort = append_variables(var_sort, numVarsBefore, formula->numVars);
+        TIMER_STOP(TIMER_SYMMETRY, t);
+        printf("Symmetry: %d generators, %d clauses and %d variables added (%llu refinement steps%s)\n",
+               symmetry.generators, symmetry.clauses_added, symmetry.aux_vars, symmetry.steps,
+               symmetry.exhausted ? ", budget exhausted" : "");
+    }
+    info.numClausesReduced = formula->numClauses;
+
+    // Initialise WatchTable
+    TIMER_START(t);
+    WatchTable *wtable = build_watch_table(formula);
+    TIMER_STOP(TIMER_WATCH_BUILD, t);
+    PERF_STOP(PERF_PHASE_PREPROCESS, perf_sample);
+
+    // Init assignments array to all unassigned
+    int *assignments = (int *)malloc(sizeof(int) * (formula->numVars + 1));
+    for (int i = 1; i < formula->numVars + 1; i++)
+    {
+        assignments[i] = -1;
+    }
+
+    // Init UndoStack
+    UndoStack *undo_stack = malloc(sizeof(UndoStack));
+    undo_stack->head = NULL;
+
+    // Branch state and decided literal per decision level, used by the progress
+    // estimate and the proof
+    branch_state = calloc(formula->numVars + 2, sizeof(unsigned char));
+    decision_path = calloc(formula->numVars + 2, sizeof(int));
+    progress.last_time = wall_seconds();
+    progress.next_report = progress.last_time + progress.interval;
+
+    if (trace_file && !trace_open(trace_file))
+    {
+        printf("Cannot write trace file %s\n", trace_file);
+    }
+
+    checkpointing.numVars = formula->numVars;
+    checkpointing.numClauses = formula->numClauses;
+    if (resume_file && access(resume_file, F_OK) != 0)
+    {
+        // The first run of a resumable job, or its search has finished
+        printf("No checkpoint %s, starting from the beginning\n", resume_file);
+    }
+    else if (resume_file)
+    {
+        if (!load_checkpoint(resume_file, formula))
+        {
+            return 1;
+        }
+        printf("Resumed from %s at depth %d (%llu decisions and %.1f s in earlier runs)\n", resume_file,
+               checkpointing.resume_depth, checkpointing.prior_decisions, checkpointing.prior_seconds);
+    }
+
+    // A lucky phase that satisfies the formula makes the search unnecessary
+    bool presolved = false;
+    if (lucky.enabled)
+    {
+        TIMER_START(t);
+        presolved = lucky_phases(formula, assignments, undo_stack);
+        TIMER_STOP(TIMER_LUCKY, t);
+        if (presolved)
+        {
+            printf("Lucky: the %s assignment satisfies the formula (%d phases tried)\n", lucky_names[lucky.phase],
+                   lucky.tried);
+        }
+    }
+
+    // So does a simulated assignment; otherwise the best one sets the phases
+    if (simulation.enabled && !presolved)
+    {
+        TIMER_START(t);
+        presolved = simulate_assignments(formula, assignments, undo_stack);
+        TIMER_STOP(TIMER_SIMULATE, t);
+        printf("Simulation: %s, best lane falsifies %d clauses (%d after propagation, %d rounds, %llu flips, %llu "
+               "steps%s)\n",
+               presolved ? "model found" : "phases set", simulation.best_unsat, simulation.initial_unsat,
+               simulation.rounds, simulation.flips, simulation.steps, simulation.exhausted ? ", budget exhausted" : "");
+    }
+
+    // Run SAT solver
+    checkpointing.next_write = wall_seconds() + checkpointing.interval;
+    checkpointing.active = true;
+    DPLLReturnType sat = presolved ? SAT : dpll(formula, assignments, undo_stack, wtable, 0);
+    checkpointing.active = false;
+    if (checkpointing.mismatch)
+    {
+        printf("Checkpoint %s does not match this search, the decisions differ at depth %d\n", resume_file,
+               search_depth);
+        return 1;
+    }
+    if (checkpointing.path && sat == TIMEOUT && checkpointing.replaying)
+    {
+        printf("Checkpoint: limit reached while replaying the resumed path, %s left as it was\n",
+               checkpointing.path);
+    }
+    else if (checkpointing.path && sat == TIMEOUT)
+    {
+        // Where the limit stopped the search, the position to resume from
+        if (write_checkpoint())
+        {
+            printf("Checkpoint: %s at depth %d (%d written)\n", checkpointing.path, search_depth,
+                   checkpointing.written);
+        }
+    }
+    else if (checkpointing.path)
+    {
+        // A finished search leaves nothing to resume
+        unlink(checkpointing.path);
+    }
+#if SAT_TRACE
+    if (trace.enabled)
+    {
+        trace_close();
+        printf("Trace: %llu records written to %s (%llu writer stalls)\n", trace.records, trace_file, trace.stalls);
+    }
+#endif
+#if SAT_PROOF
+    if (proof.file)
+    {
+        proof_close();
+        printf("Proof: %llu clauses added, %llu deleted in %s%s\n", proof.added, proof.deleted, proof_file,
+               sat == UNSAT ? "" : " (incomplete, no UNSAT answer)");
+    }
+#endif
+
+    // Never report a model that does not satisfy the formula
+    if (sat == SAT)
+    {
+        reconstruct_model(assignments);
+    }
+    bool model_ok = sat != SAT || verify_model(formula, assignments);
+    if (sat == SAT && show_model && model_ok)
+    {
+        print_model(assignments, numVarsOriginal);
+    }
+    else if (sat == TIMEOUT && show_model)
+    {
+        print_partial_assignment(formula, assignments, numVarsOriginal);
+    }
+
+    if (cache.dir && (sat == UNSAT || (sat == SAT && model_ok)))
+    {
+        TIMER_START(t);
+        cache_store(sat, assignments, numVarsOriginal);
+        TIMER_STOP(TIMER_CACHE, t);
+    }
+
+    // Further queries on the same formula, watch table and undo stack
+    if (sat == SAT && model_ok && backbone.enabled)
+    {
+        sat = compute_backbone(formula, assignments, undo_stack, wtable, numVarsOriginal);
+        if (sat == SAT)
+        {
+            printf("Backbone: %d of %d variables (%llu queries: %llu SAT, %llu UNSAT)\n", backbone.size,
+                   numVarsOriginal, backbone.queries, backbone.sat_queries, backbone.unsat_queries);
+        }
+        else
+        {
+            printf("Backbone: incomplete, %d literals confirmed and %d candidates open (%llu queries: %llu SAT, "
+                   "%llu UNSAT)\n",
+                   backbone.size, backbone.candidates, backbone.queries, backbone.sat_queries,
+                   backbone.unsat_queries);
+        }
+        print_backbone();
+    }
+
+    // Free Memory
+    free(var_sort);
+    free(backbone.literals);
+    free(branch_state);
+    free(decision_path);
+    free(decision_phase);
+    free(checkpointing.resume_path);
+    free(assignments);
+    g_slist_free_full(undo_stack->head, free);
+    free(undo_stack);
+    free_watchtable(wtable);
+    free_formula(formula);
+
+    // The JSON record still reports the recognized gates
+    int exit_code = finish_run(sat, model_ok, &info, stats_json);
+    free_elimination();
+    return exit_code;
+}
+#endif
+
+DPLLReturnType dpll(Formula *formula, int *assignments, UndoStack *undo_stack, WatchTable *wtable, int depth)
+{
+    // Resource limit case
+    search_depth = depth;
+    if (checkpointing.replaying && depth == checkpointing.resume_depth)
+    {
+        checkpointing.replaying = false;
+    }
+    if (limit_exceeded())
+    {
+        return TIMEOUT;
+    }
+
+    // Undo Checkpoint
+    GSList *checkpoint = undo_stack->head;
+
+    PerfSample perf_sample;
+    PERF_START(perf_sample);
+#if SAT_TRACE
+    unsigned long long propagations_before = stats.propagations;
+#endif
+    double t = 0.0;
+    TIMER_START(t);
+    bool propagated = unit_propagate_2watchlit(formula, assignments, undo_stack, wtable);
+    TIMER_STOP(TIMER_PROPAGATE, t);
+    PERF_STOP(PERF_PHASE_PROPAGATE, perf_sample);
+    TRACE_EMIT(TRACE_PROPAGATE, depth, (int)(stats.propagations - propagations_before));
+    if (!propagated)
+    {
+        STAT_INC(conflicts);
+        TRACE_EMIT(TRACE_CONFLICT, depth, 0);
+        PROOF_UNSAT(depth);
+        undo_to_checkpoint(undo_stack, checkpoint, formula, assignments, wtable);
+        return UNSAT;
+    }
+
+#if SAT_PURE_LITERAL
+    TIMER_START(t);
+    bool pure_ok = pure_literal_elimination(formula, assignments, undo_stack);
+    TIMER_STOP(TIMER_PURE_LITERAL, t);
+    if (!pure_ok)
+    {
+        STAT_INC(conflicts);
+        TRACE_EMIT(TRACE_CONFLICT, depth, 0);
+        PROOF_UNSAT(depth);
+        undo_to_checkpoint(undo_stack, checkpoint, formula, assignments, wtable);
+        return UNSAT;
+    }
+#endif
+
+    // Check if all clauses are satisfied.
+    // Extra check for any clauses that might have been satisified, without a flag
+    bool all_satisfied = true;
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (!formula->clauses[i].satisfied)
+        {
+            bool missing_flag = false;
+            for (int j = 0; j < formula->clauses[i].size; j++)
+            {
+                Literal lit = formula->clauses[i].literals[j];
+                int as = assignments[lit.var];
+                if ((as == 0 && lit.neg) || (as == 1 && !lit.neg))
+                {
+                    missing_flag = true;
+                    break;
+                }
+            }
+
+            if (missing_flag)
+            {
+                formula->clauses[i].satisfied = true;
+                push_clause_satisfy(undo_stack, i);
+            }
+            else
+            {
+                all_satisfied = false;
+                break;
+            }
+        }
+    }
+
+    if (all_satisfied)
+    {
+        return SAT;
+    }
+
+    PERF_START(perf_sample);
+    int x = pick_unassigned_variable(formula, assignments);
+    if (x == -1)
+    {
+        STAT_INC(conflicts);
+        TRACE_EMIT(TRACE_CONFLICT, depth, 0);
+        PROOF_UNSAT(depth);
+        return UNSAT;
+    }
+    else
+    {
+        // Create a second checkpoint to undo the assignment + clause satisfy actions if needed.
+        GSList *checkpoint2 = undo_stack->head;
+
+        // The first branch takes the variable's phase, false unless --simulate set one
+        int value = decision_phase ? decision_phase[x] : 0;
+        int first = value ? x : -x;
+
+        // On the path of a resumed checkpoint the same variable must come up,
+        // and a first branch that the checkpoint had refuted is skipped. The
+        // replayed decisions were counted by the earlier run.
+        bool replay = checkpointing.replaying;
+        if (replay && x != abs(checkpointing.resume_path[depth]))
+        {
+            checkpointing.mismatch = true;
+            return TIMEOUT;
+        }
+
+        DPLLReturnType result1 = UNSAT;
+        if (!replay || checkpointing.resume_path[depth] == first)
+        {
+            if (!replay)
+                STAT_INC(decisions);
+            branch_state[depth] = 0;
+            decision_path[depth] = first;
+            assignments[x] = value;
+            push_assignment(undo_stack, x);
+            satisfy_clauses_after_assignment(formula, assignments, undo_stack);
+            PERF_STOP(PERF_PHASE_DECISION, perf_sample);
+            TRACE_EMIT(TRACE_DECISION, depth, first);
+
+            result1 = dpll(formula, assignments, undo_stack, wtable, depth + 1);
+            if (replay && checkpointing.replaying)
+            {
+                checkpointing.mismatch = true; // Returned before reaching the resumed node
+                return TIMEOUT;
+            }
+        }
+        if (result1 == UNSAT)
+        {
+            TRACE_EMIT(TRACE_BACKTRACK, depth, first);
+
+            // Second assignment case
+            undo_to_checkpoint(undo_stack, checkpoint2, formula, assignments, wtable);
+            PERF_START(perf_sample);
+            if (!replay)
+                STAT_INC(decisions);
+            branch_state[depth] = 1;
+            decision_path[depth] = -first;
+            assignments[x] = !value;
+            push_assignment(undo_stack, x);
+            satisfy_clauses_after_assignment(formula, assignments, undo_stack);
+            PERF_STOP(PERF_PHASE_DECISION, perf_sample);
+            TRACE_EMIT(TRACE_DECISION, depth, -first);
+
+            DPLLReturnType result2 = dpll(formula, assignments, undo_stack, wtable, depth + 1);
+            if (replay && checkpointing.replaying)
+            {
+                checkpointing.mismatch = true;
+                return TIMEOUT;
+            }
+            if (result2 == UNSAT)
+            {
+                TRACE_EMIT(TRACE_BACKTRACK, depth, -first);
+                PROOF_UNSAT(depth);
+                undo_to_checkpoint(undo_stack, checkpoint, formula, assignments, wtable);
+            }
+
+            return result2;
+        }
+        else
+        {
+            // Returns SAT or TIMEOUT
+            return result1;
+        }
+    }
+}
+
+bool unit_propagate_dpll(Formula *formula, int *assignments, UndoStack *stack)
+{
+    bool progress = true;
+
+    while (progress)
+    {
+        progress = false;
+
+        for (int i = 0; i < formula->numClauses; i++)
+        {
+            if (formula->clauses[i].satisfied)
+            {
+                continue;
+            }
+
+            Clause clause = formula->clauses[i];
+
+            int unassigned_count = 0;
+            Literal unassigned_lit;
+            bool clause_satisfied = false;
+
+            for (int j = 0; j < clause.size; j++)
+            {
+                Literal lit = clause.literals[j];
+                int value = assignments[lit.var];
+
+                if (value == -1)
+                {
+                    unassigned_count++;
+                    unassigned_lit = lit;
+                }
+                else
+                {
+                    if ((value == 1 && !lit.neg) || (value == 0 && lit.neg))
+                    {
+                        clause_satisfied = true;
+                        break;
+                    }
+                }
+            }
+
+            if (clause_satisfied)
+            {
+                continue;
+            }
+
+            if (unassigned_count == 0)
+            {
+                return false;
+            }
+            else if (unassigned_count == 1)
+            {
+                assignments[unassigned_lit.var] = (int)!unassigned_lit.neg;
+                push_assignment(stack, unassigned_lit.var);
+
+                progress = true;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Add the literals from any unit clauses into the queue. Returns false if a
+// clause has all of its literals false.
+bool queue_unit_clauses(Formula *formula, int *assignments, GQueue *queue)
+{
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        if (clause->satisfied)
+        {
+            continue;
+        }
+
+        int unassigned_counter = 0;
+        bool true_literal = false; // Satisfied without the flag set
+        Literal *lit_copy = malloc(sizeof(Literal));
+        for (int j = 0; j < clause->size && !true_literal; j++)
+        {
+            Literal lit = clause->literals[j];
+            int value = assignments[lit.var];
+            if (value == -1)
+            {
+                if (unassigned_counter == 0)
+                {
+                    lit_copy->var = lit.var;
+                    lit_copy->neg = lit.neg;
+                }
+                unassigned_counter++;
+            }
+            else
+            {
+                true_literal = value == !lit.neg;
+            }
+        }
+
+        if (unassigned_counter == 1 && !true_literal)
+        {
+            g_queue_push_tail(queue, lit_copy);
+        }
+        else
+        {
+            free(lit_copy);
+            if (unassigned_counter == 0 && !true_literal)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool unit_propagate_2watchlit(Formula *formula, int *assignments, UndoStack *stack, WatchTable *wtable)
+{
+    // Init a new queue for storing unit literals
+    GQueue *queue = g_queue_new();
+    if (!queue_unit_clauses(formula, assignments, queue))
+    {
+        g_queue_free_full(queue, free);
+        return false;
+    }
+
+    while (!g_queue_is_empty(queue))
+    {
+        // Get the next literal. If it is unassigned, give it an assignment that satisfies it.
+        Literal *lit = g_queue_pop_head(queue);
+
+        if (assignments[lit->var] == -1)
+        {
+            // If literal is negated, set to false, else to true
+            STAT_INC(propagations);
+            assignments[lit->var] = lit->neg ? 0 : 1;
+            push_assignment(stack, lit->var);
+
+            int index = watchlist_index(*lit, formula->numVars);
+            GArray *wlist = wtable->watch_lists[index];
+            for (int i = 0; i < wlist->len; i++)
+            {
+                int indexc = g_array_index(wlist, int, i);
+                Clause *clause = &formula->clauses[indexc];
+                if (!clause->satisfied)
+                {
+                    clause->satisfied = true;
+                    push_clause_satisfy(stack, indexc);
+                }
+            }
+        }
+
+        // Find the opposite literal.
+        Literal oplit = {lit->var, !lit->neg};
+        int index = watchlist_index(oplit, formula->numVars);
+        GArray *wlist = wtable->watch_lists[index];
+        free(lit);
+
+        // For each clause that watches the opposite literal
+        for (int i = 0; i < wlist->len; i++)
+        {
+            int indexi = g_array_index(wlist, int, i);
+            Clause *clause = &formula->clauses[indexi];
+            STAT_INC(watch_visits);
+
+            if (clause->satisfied)
+            {
+                continue;
+            }
+
+            // Find the other literal watched by this clause
+            Literal other = {0, false}; // 0 cannot be an actual literal.
+            for (int j = 0; j < clause->size; j++)
+            {
+                Literal l = clause->literals[j];
+                int indexj = watchlist_index(l, formula->numVars);
+
+                // Is the literal we are looking at the opposite literal?
+                if (l.var == oplit.var && l.neg == oplit.neg)
+                {
+                    continue;
+                }
+
+                // In the watch list of the next literal, check if this clause is watching it.
+                GArray *twlist = wtable->watch_lists[indexj];
+                for (int k = 0; k < twlist->len; k++)
+                {
+                    if (g_array_index(twlist, int, k) == indexi)
+                    {
+                        other = l;
+                        break;
+                    }
+                }
+
+                // If we found the other watch, exit loop
+                if (other.var != 0)
+                {
+                    break;
+                }
+            }
+
+            // If there is no other literal being watched, eg. unit clause
+            if (other.var == 0)
+            {
+                // Skip if already satisfied
+                if (clause->satisfied)
+                {
+                    continue;
+                }
+
+                // Otherwise, check if it is an unsatisfiable clause based on current assignments
+                bool all_false = true;
+                for (int x = 0; x < clause->size; x++)
+                {
+                    Literal tlit = clause->literals[x];
+                    int assign = assignments[tlit.var];
+                    all_false = all_false && ((assign == 0 && !tlit.neg) || (assign == 1 && tlit.neg));
+                }
+
+                if (all_false)
+                {
+                    g_queue_free_full(queue, free);
+                    return false;
+                }
+                // If it isnt, then add it to the queue. (This may be a duplicate of the original step, but this shouldnt matter too much to performance.)
+                else
+                {
+                    Literal *lit_copy = malloc(sizeof(Literal));
+                    lit_copy->var = oplit.var;
+                    lit_copy->neg = oplit.neg;
+                    g_queue_push_tail(queue, lit_copy);
+                    continue;
+                }
+            }
+
+            // If the other watched literal is already satisfied, skip the clause.
+            int other_a = assignments[other.var];
+            if ((other_a == 1 && !other.neg) || (other_a == 0 && other.neg))
+            {
+                continue;
+            }
+
+            // Now we try to replace the watched literal with a new literal.
+            bool found = false;
+            for (int j = 0; j < clause->size; j++)
+            {
+                Literal nlit = clause->literals[j];
+                int indexn = watchlist_index(nlit, formula->numVars);
+
+                // If it matches one of the literals the clause is already looking at, skip it.
+                if (indexn == index || (nlit.var == other.var && nlit.neg == other.neg))
+                {
+                    continue;
+                }
+
+                // If the next literal is unassigned, or satisfies the clause, then we watch it.
+                int assign_nlit = assignments[nlit.var];
+                if (assign_nlit == -1 || (assign_nlit == 0 && nlit.neg) || (assign_nlit == 1 && !nlit.neg))
+                {
+                    watchtable_remove(wtable, index, indexi, stack);
+                    watchtable_add(wtable, indexn, indexi, stack);
+                    found = true;
+                    break;
+                }
+            }
+
+            // If we could find no new literals to watch because of a unit clause or conflicts
+            if (!found)
+            {
+                if (assignments[other.var] == -1)
+                {
+                    STAT_INC(propagations);
+                    assignments[other.var] = other.neg ? 0 : 1;
+                    push_assignment(stack, other.var);
+
+                    int index = watchlist_index(other, formula->numVars);
+                    GArray *wlist = wtable->watch_lists[index];
+                    for (int i = 0; i < wlist->len; i++)
+                    {
+                        int indexc = g_array_index(wlist, int, i);
+                        Clause *clause = &formula->clauses[indexc];
+                        if (!clause->satisfied)
+                        {
+                            clause->satisfied = true;
+                            push_clause_satisfy(stack, indexc);
+                        }
+                    }
+
+                    Literal *lit_copy = malloc(sizeof(Literal));
+                    lit_copy->var = other.var;
+                    lit_copy->neg = other.neg;
+                    g_queue_push_tail(queue, lit_copy);
+                }
+                else
+                {
+                    g_queue_free_full(queue, free);
                     return false;
                 }
-                // If it isnt, then add it to the queue. (This may be a duplicate of the original step, but this shouldnt matter too much to performance.)
-                else
+            }
+        }
+
+        // Decisions do not go through the queue, so watches can stay on their
+        // false literals and a clause can become unit unnoticed. Rescan before
+        // stopping, every rescan that finds a unit assigns at least one variable.
+        if (g_queue_is_empty(queue) && !queue_unit_clauses(formula, assignments, queue))
+        {
+            g_queue_free_full(queue, free);
+            return false;
+        }
+    }
+
+    g_queue_free_full(queue, free);
+    return true;
+}
+
+bool pure_literal_elimination(Formula *formula, int *assignments, UndoStack *stack)
+{
+    bool *positive_units = calloc(formula->numVars + 1, sizeof(bool));
+    bool *negative_units = calloc(formula->numVars + 1, sizeof(bool));
+
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (formula->clauses[i].satisfied)
+        {
+            continue;
+        }
+
+        for (int j = 0; j < formula->clauses[i].size; j++)
+        {
+            if (assignments[formula->clauses[i].literals[j].var] != -1)
+            {
+                continue; // Skipping already assigned variables
+            }
+
+            if (formula->clauses[i].literals[j].neg)
+            {
+                negative_units[formula->clauses[i].literals[j].var] = true;
+            }
+            else
+            {
+                positive_units[formula->clauses[i].literals[j].var] = true;
+            }
+        }
+    }
+
+    bool *lit_purity = calloc(formula->numVars + 1, sizeof(bool));
+    for (int var = 1; var <= formula->numVars; var++)
+    {
+        if (assignments[var] != -1)
+        {
+            continue; // Skipping already assigned variables
+        }
+
+        if (positive_units[var] && !negative_units[var])
+        {
+            lit_purity[var] = true;
+            assignments[var] = 1;
+            push_assignment(stack, var);
+        }
+        else if (!positive_units[var] && negative_units[var])
+        {
+            lit_purity[var] = true;
+            assignments[var] = 0;
+            push_assignment(stack, var);
+        }
+    }
+
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        bool satisfied = false;
+
+        for (int j = 0; j < formula->clauses[i].size; j++)
+        {
+            if (lit_purity[formula->clauses[i].literals[j].var])
+            {
+                satisfied = true;
+                break;
+            }
+        }
+
+        if (satisfied)
+        {
+            formula->clauses[i].satisfied = true;
+            push_clause_satisfy(stack, i);
+        }
+    }
+
+    free(positive_units);
+    free(negative_units);
+    free(lit_purity);
+
+    return true;
+}
+
+int pick_unassigned_variable(Formula *formula, int *assignments)
+{
+    // Pick first unassigned variable
+    // for (int i = 1; i < formula->numVars; i++)
+    // {
+    //     if (assignments[i] == -1)
+    //     {
+    //         return i;
+    //     }
+    // }
+
+    // Pick most often occuring variable
+    for (int i = 0; i < formula->numVars; i++)
+    {
+        if (var_sort[i] == 0)
+        {
+            return -1;
+        }
+
+        if (assignments[var_sort[i]] == -1)
+        {
+            return var_sort[i];
+        }
+    }
+
+    return -1;
+}
+
+// Drop repeated literals: a clause watching the same literal twice has no
+// second watch and would never become unit
+void remove_duplicate_literals(Clause *clause)
+{
+    int size = 0;
+    for (int i = 0; i < clause->size; i++)
+    {
+        bool duplicate = false;
+        for (int j = 0; j < size; j++)
+        {
+            if (clause->literals[j].var == clause->literals[i].var && clause->literals[j].neg == clause->literals[i].neg)
+            {
+                duplicate = true;
+                break;
+            }
+        }
+
+        if (!duplicate)
+        {
+            clause->literals[size++] = clause->literals[i];
+        }
+    }
+    clause->size = size;
+}
+
+Formula *parse_formula(const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    int numVars = 0, numClauses = 0;
+    char *line = NULL;
+    size_t len = 0;
+
+    while (getline(&line, &len, file) != -1)
+    {
+        if (line[0] == 'p')
+        {
+            sscanf(line, "p cnf %d %d", &numVars, &numClauses);
+            break;
+        }
+    }
+
+    Formula *formula = (Formula *)malloc(sizeof(Formula));
+    formula->numVars = numVars;
+    formula->numClauses = numClauses;
+    formula->clauses = (Clause *)malloc(sizeof(Clause) * numClauses);
+
+    printf("| Vars: %d | Clauses: %d |\n", numVars, numClauses);
+
+    int clauseIndex = 0;
+    while (getline(&line, &len, file) != -1 && clauseIndex < numClauses)
+    {
+        if (line[0] == 'c' || line[0] == 'p' || strlen(line) < 2)
+            continue;
+
+        int lit;
+        int clauseSize = 0;
+        int capacity = 4; // Starting capacity that can be doubled if more space is needed
+        Literal *literals = (Literal *)malloc(sizeof(Literal) * capacity);
+
+        char *token = strtok(line, " \t\n");
+        while (token != NULL)
+        {
+            lit = atoi(token);
+            if (lit == 0)
+                break;
+
+            if (clauseSize >= capacity)
+            {
+                capacity *= 2;
+                literals = (Literal *)realloc(literals, sizeof(Literal) * capacity);
+            }
+
+            literals[clauseSize].var = abs(lit);
+            literals[clauseSize].neg = lit < 0;
+            clauseSize++;
+
+            token = strtok(NULL, " \t\n");
+        }
+
+        formula->clauses[clauseIndex].size = clauseSize;
+        formula->clauses[clauseIndex].literals = literals;
+        formula->clauses[clauseIndex].satisfied = false;
+        remove_duplicate_literals(&formula->clauses[clauseIndex]);
+        clauseIndex++;
+    }
+
+    // Resize if the file does not contain up the the correct amount of clauses.
+    if (clauseIndex < numClauses)
+    {
+        Clause *resize_clauses = realloc(formula->clauses, sizeof(Clause) * clauseIndex);
+        formula->numClauses = clauseIndex;
+    }
+
+    free(line);
+    fclose(file);
+
+    return formula;
+}
+
+// Undo Stack Push Functions
+
+void push_assignment(UndoStack *stack, int var)
+{
+    UndoEntry *e = malloc(sizeof(UndoEntry));
+    e->type = ASSIGNMENT;
+    e->var = var;
+    stack->head = g_slist_prepend(stack->head, e);
+    trail_size++;
+}
+
+void push_clause_satisfy(UndoStack *stack, int index)
+{
+    UndoEntry *e = malloc(sizeof(UndoEntry));
+    e->type = CLAUSE_SATISFY;
+    e->index = index;
+    stack->head = g_slist_prepend(stack->head, e);
+}
+
+void watchtable_add(WatchTable *wtable, int index, int value, UndoStack *stack)
+{
+    GArray *arr = wtable->watch_lists[index];
+    g_array_append_val(arr, value);
+
+    UndoEntry *e = malloc(sizeof(UndoEntry));
+    e->type = WATCHLIST_ADD;
+    e->index = index;
+    e->var = value;
+    stack->head = g_slist_prepend(stack->head, e);
+}
+
+void watchtable_remove(WatchTable *wtable, int index, int value, UndoStack *stack)
+{
+    GArray *arr = wtable->watch_lists[index];
+    for (int i = 0; i < arr->len; i++)
+    {
+        if (g_array_index(arr, int, i) == value)
+        {
+            g_array_remove_index(arr, i);
+            break;
+        }
+    }
+
+    UndoEntry *e = malloc(sizeof(UndoEntry));
+    e->type = WATCHLIST_REMOVE;
+    e->index = index;
+    e->var = value;
+    stack->head = g_slist_prepend(stack->head, e);
+}
+
+void undo_to_checkpoint(UndoStack *stack, GSList *checkpoint, Formula *formula, int *assignments, WatchTable *wtable)
+{
+    PerfSample perf_sample;
+    PERF_START(perf_sample);
+    double t = 0.0;
+    TIMER_START(t);
+    while (stack->head != checkpoint)
+    {
+        UndoEntry *e = stack->head->data;
+        STAT_INC(undo_entries);
+        if (e->type == ASSIGNMENT)
+        {
+            assignments[e->var] = -1;
+            trail_size--;
+        }
+        else if (e->type == WATCHLIST_ADD)
+        {
+            GArray *arr = wtable->watch_lists[e->index];
+            for (int i = 0; i < arr->len; i++)
+            {
+                if (g_array_index(arr, int, i) == e->var)
+                {
+                    g_array_remove_index(arr, i);
+                    break;
+                }
+            }
+        }
+        else if (e->type == WATCHLIST_REMOVE)
+        {
+            GArray *arr = wtable->watch_lists[e->index];
+            g_array_append_val(arr, e->var);
+        }
+        else if (e->type == CLAUSE_SATISFY)
+        {
+            formula->clauses[e->index].satisfied = false;
+        }
+
+        GSList *next = stack->head->next;
+        free(e);
+        g_slist_free_1(stack->head);
+        stack->head = next;
+    }
+    TIMER_STOP(TIMER_BACKTRACK, t);
+    PERF_STOP(PERF_PHASE_BACKTRACK, perf_sample);
+}
+
+// WatchTable Init and Free functions
+
+WatchTable *init_empty_watch_table(Formula *formula)
+{
+    WatchTable *wtable = (WatchTable *)malloc(sizeof(WatchTable));
+    wtable->numVars = formula->numVars * 2 + 1;
+    wtable->watch_lists = (GArray **)calloc(wtable->numVars, sizeof(GArray *));
+
+    for (int i = 0; i < wtable->numVars; i++)
+    {
+        wtable->watch_lists[i] = g_array_new(FALSE, FALSE, sizeof(int));
+    }
+
+    return wtable;
+}
+
+// Watch the first two literals of every clause (the only literal of unit clauses)
+WatchTable *build_watch_table(Formula *formula)
+{
+    WatchTable *wtable = init_empty_watch_table(formula);
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        Clause clause = formula->clauses[i];
+        if (clause.size == 0)
+        {
+            continue;
+        }
+        else if (clause.size == 1)
+        {
+            int index = watchlist_index(clause.literals[0], formula->numVars);
+            GArray *arr = wtable->watch_lists[index];
+            g_array_append_val(arr, i);
+        }
+        else
+        {
+            int index1 = watchlist_index(clause.literals[0], formula->numVars);
+            int index2 = watchlist_index(clause.literals[1], formula->numVars);
+            GArray *arr1 = wtable->watch_lists[index1];
+            GArray *arr2 = wtable->watch_lists[index2];
+            g_array_append_val(arr1, i);
+            g_array_append_val(arr2, i);
+        }
+    }
+
+    return wtable;
+}
+
+void free_watchtable(WatchTable *wtable)
+{
+    if (!wtable)
+        return;
+
+    for (int i = 0; i < wtable->numVars; i++)
+    {
+        if (wtable->watch_lists[i])
+        {
+            g_array_free(wtable->watch_lists[i], TRUE);
+        }
+    }
+
+    g_free(wtable->watch_lists);
+
+    g_free(wtable);
+}
+
+// Model check against every clause, unassigned variables count as false
+bool verify_model(Formula *formula, int *assignments)
+{
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        bool satisfied = false;
+        for (int j = 0; j < clause->size && !satisfied; j++)
+        {
+            Literal lit = clause->literals[j];
+            satisfied = lit.neg ? assignments[lit.var] != 1 : assignments[lit.var] == 1;
+        }
+
+        if (!satisfied)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// DIMACS model lines ("v ... 0"), unassigned variables are printed as false
+void write_model(FILE *out, const int *assignments, int numVars)
+{
+    fprintf(out, "v");
+    for (int var = 1; var <= numVars; var++)
+    {
+        fprintf(out, " %d", assignments[var] == 1 ? var : -var);
+        if (var % 20 == 0 && var < numVars)
+        {
+            fprintf(out, "\nv");
+        }
+    }
+    fprintf(out, " 0\n");
+}
+
+void print_model(int *assignments, int numVars)
+{
+    write_model(stdout, assignments, numVars);
+}
+
+// Assigned literals of a stopped search as v lines. The search stops at the top
+// of a dpll call, after propagation reached a fixpoint one level up, so the
+// partial assignment falsifies no clause.
+void print_partial_assignment(Formula *formula, int *assignments, int numVars)
+{
+    int assigned = 0, satisfied = 0;
+    for (int var = 1; var <= numVars; var++)
+    {
+        assigned += assignments[var] != -1;
+    }
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        for (int j = 0; j < clause->size; j++)
+        {
+            Literal lit = clause->literals[j];
+            if (assignments[lit.var] == (lit.neg ? 0 : 1))
+            {
+                satisfied++;
+                break;
+            }
+        }
+    }
+
+    printf("c partial assignment: %d of %d variables, %d of %d clauses satisfied\n", assigned, numVars, satisfied,
+           formula->numClauses);
+    printf("v");
+    int printed = 0;
+    for (int var = 1; var <= numVars; var++)
+    {
+        if (assignments[var] == -1)
+        {
+            continue;
+        }
+        printf(" %d", assignments[var] == 1 ? var : -var);
+        if (++printed % 20 == 0)
+        {
+            printf("\nv");
+        }
+    }
+    printf(" 0\n");
+}
+
+// Formula Free function
+
+void free_formula(Formula *formula)
+{
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        free(formula->clauses[i].literals);
+    }
+    free(formula->clauses);
+    free(formula);
+}
+
+// Function to satisfy clauses after an assignment occurs
+
+void satisfy_clauses_after_assignment(Formula *formula, int *assignments, UndoStack *stack)
+{
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+
+        if (clause->satisfied)
+        {
+            continue;
+        }
+
+        bool satisfied = false;
+        for (int j = 0; j < clause->size; j++)
+        {
+            Literal lit = clause->literals[j];
+            int a = assignments[lit.var];
+            if ((a == 0 && lit.neg) || (a == 1 && !lit.neg))
+            {
+                clause->satisfied = true;
+                push_clause_satisfy(stack, i);
+                break;
+            }
+        }
+    }
+}
+
+// Superset helper methods
+
+gint lit_key(Literal *lit)
+{
+    return lit->neg ? -lit->var : lit->var;
+}
+
+gboolean clause_subset(Clause *a, Clause *b)
+{
+    GHashTable *setB = g_hash_table_new(g_int_hash, g_int_equal);
+    for (int i = 0; i < b->size; i++)
+    {
+        gint *k = g_new(gint, 1);
+        *k = lit_key(&b->literals[i]);
+        g_hash_table_add(setB, k);
+    }
+
+    gboolean is_subset = true;
+    for (int i = 0; i < a->size; i++)
+    {
+        gint key = lit_key(&a->literals[i]);
+        if (!g_hash_table_contains(setB, &key))
+        {
+            is_subset = false;
+            break;
+        }
+    }
+
+    g_hash_table_destroy(setB);
+    return is_subset;
+}
+
+void remove_supersets(Formula *formula)
+{
+    gboolean *remove_marked = g_new0(gboolean, formula->numClauses);
+
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (remove_marked[i])
+        {
+            continue;
+        }
+
+        for (int j = 0; j < formula->numClauses; j++)
+        {
+            if (i == j || remove_marked[j])
+            {
+                continue;
+            }
+
+            Clause *clausei = &formula->clauses[i];
+            Clause *clausej = &formula->clauses[j];
+
+            if (clausei->size >= clausej->size && clause_subset(clausej, clausei))
+            {
+                remove_marked[i] = true;
+                break;
+            }
+        }
+    }
+
+    int counter = 0;
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (!remove_marked[i])
+        {
+            formula->clauses[counter] = formula->clauses[i];
+            counter++;
+        }
+        else
+        {
+            free(formula->clauses[i].literals);
+        }
+    }
+
+    formula->numClauses = counter;
+    formula->clauses = realloc(formula->clauses, sizeof(Clause) * counter);
+    g_free(remove_marked);
+}
+
+// Symmetry breaking
+
+// Colored graph of the CNF: one node per literal (2(v-1) for v, 2(v-1)+1 for -v)
+// and one per clause, with literal-clause edges and an edge between the two
+// literals of every variable. Automorphisms that fix the colors map literals to
+// literals, respect negation and map clauses to clauses.
+SymGraph *build_symmetry_graph(Formula *formula)
+{
+    SymGraph *graph = malloc(sizeof(SymGraph));
+    graph->numLitNodes = 2 * formula->numVars;
+    graph->numNodes = graph->numLitNodes + formula->numClauses;
+    graph->color = malloc(sizeof(int) * graph->numNodes);
+    graph->adj_start = calloc(graph->numNodes + 1, sizeof(int));
+
+    for (int v = 0; v < graph->numLitNodes; v++)
+    {
+        graph->color[v] = 0;
+        graph->adj_start[v + 1] = 1;
+    }
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        graph->color[graph->numLitNodes + i] = 1;
+        graph->adj_start[graph->numLitNodes + i + 1] = clause->size;
+        for (int j = 0; j < clause->size; j++)
+        {
+            graph->adj_start[sym_lit_node(clause->literals[j]) + 1]++;
+        }
+    }
+    for (int v = 0; v < graph->numNodes; v++)
+    {
+        graph->adj_start[v + 1] += graph->adj_start[v];
+    }
+
+    graph->adj = malloc(sizeof(int) * graph->adj_start[graph->numNodes]);
+    int *fill = malloc(sizeof(int) * graph->numNodes);
+    memcpy(fill, graph->adj_start, sizeof(int) * graph->numNodes);
+    for (int v = 0; v < graph->numLitNodes; v++)
+    {
+        graph->adj[fill[v]++] = v ^ 1;
+    }
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        int node = graph->numLitNodes + i;
+        for (int j = 0; j < clause->size; j++)
+        {
+            int lit = sym_lit_node(clause->literals[j]);
+            graph->adj[fill[node]++] = lit;
+            graph->adj[fill[lit]++] = node;
+        }
+    }
+    free(fill);
+
+    return graph;
+}
+
+void free_symmetry_graph(SymGraph *graph)
+{
+    free(graph->color);
+    free(graph->adj_start);
+    free(graph->adj);
+    free(graph);
+}
+
+int sym_lit_node(Literal lit)
+{
+    return 2 * (lit.var - 1) + lit.neg;
+}
+
+SymPartition *sym_partition_new(int numNodes)
+{
+    SymPartition *p = malloc(sizeof(SymPartition));
+    p->numNodes = numNodes;
+    p->lab = malloc(sizeof(int) * numNodes);
+    p->cell_of = malloc(sizeof(int) * numNodes);
+    p->cell_end = malloc(sizeof(int) * numNodes);
+    p->numCells = 0;
+    return p;
+}
+
+// Copies count against the budget, on deep searches they cost more than refinement
+void sym_partition_copy(SymPartition *dst, const SymPartition *src)
+{
+    symmetry.steps += src->numNodes;
+    memcpy(dst->lab, src->lab, sizeof(int) * src->numNodes);
+    memcpy(dst->cell_of, src->cell_of, sizeof(int) * src->numNodes);
+    memcpy(dst->cell_end, src->cell_end, sizeof(int) * src->numNodes);
+    dst->numCells = src->numCells;
+}
+
+void sym_partition_free(SymPartition *p)
+{
+    free(p->lab);
+    free(p->cell_of);
+    free(p->cell_end);
+    free(p);
+}
+
+int compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int compare_count(const void *a, const void *b, void *count)
+{
+    int x = ((int *)count)[*(const int *)a], y = ((int *)count)[*(const int *)b];
+    return (x > y) - (x < y);
+}
+
+// Refine p to the coarsest equitable partition below it, starting from the given
+// splitter cells. Cells are split by the number of neighbours in the splitter,
+// pieces ordered by that number, so the result only depends on the structure and
+// not on node names. Returns a fingerprint of the splits for comparing search
+// paths, and 0 once the step budget is spent.
+uint64_t sym_refine(const SymGraph *graph, SymPartition *p, SymWork *work, const int *splitters, int numSplitters)
+{
+    int capacity = graph->numNodes + 1;
+    int head = 0, tail = 0;
+    for (int i = 0; i < numSplitters; i++)
+    {
+        work->queue[tail++] = splitters[i];
+        work->in_queue[splitters[i]] = true;
+    }
+
+    uint64_t fingerprint = 1469598103934665603ull;
+    while (head != tail)
+    {
+        int s = work->queue[head];
+        head = (head + 1) % capacity;
+        work->in_queue[s] = false;
+
+        // Neighbour counts into the splitter
+        int numTouched = 0, numCells = 0;
+        for (int i = s; i < p->cell_end[s]; i++)
+        {
+            int u = p->lab[i];
+            symmetry.steps += graph->adj_start[u + 1] - graph->adj_start[u];
+            for (int e = graph->adj_start[u]; e < graph->adj_start[u + 1]; e++)
+            {
+                int v = graph->adj[e];
+                if (work->count[v]++ == 0)
+                {
+                    work->touched[numTouched++] = v;
+                    int c = p->cell_of[v];
+                    if (!work->cell_mark[c])
+                    {
+                        work->cell_mark[c] = true;
+                        work->cells[numCells++] = c;
+                    }
+                }
+            }
+        }
+
+        qsort(work->cells, numCells, sizeof(int), compare_int);
+        for (int k = 0; k < numCells; k++)
+        {
+            int c = work->cells[k];
+            int end = p->cell_end[c];
+            work->cell_mark[c] = false;
+            if (end - c == 1)
+            {
+                continue;
+            }
+
+            qsort_r(&p->lab[c], end - c, sizeof(int), compare_count, work->count);
+            if (work->count[p->lab[c]] == work->count[p->lab[end - 1]])
+            {
+                continue;
+            }
+
+            // Split into pieces of equal count, remember the largest one
+            bool was_queued = work->in_queue[c];
+            int largest = c, largest_size = 0;
+            int start = c;
+            for (int i = c + 1; i <= end; i++)
+            {
+                if (i == end || work->count[p->lab[i]] != work->count[p->lab[start]])
+                {
+                    p->cell_end[start] = i;
+                    for (int j = start; j < i; j++)
+                    {
+                        p->cell_of[p->lab[j]] = start;
+                    }
+                    if (i - start > largest_size)
+                    {
+                        largest = start;
+                        largest_size = i - start;
+                    }
+                    fingerprint = (fingerprint ^ (uint64_t)(start * 31 + work->count[p->lab[start]])) * 1099511628211ull;
+                    if (start != c)
+                    {
+                        p->numCells++;
+                    }
+                    start = i;
+                }
+            }
+
+            // Hopcroft: a cell already queued needs all pieces, otherwise all but the largest
+            for (int piece = c; piece < end; piece = p->cell_end[piece])
+            {
+                if (work->in_queue[piece] || (!was_queued && piece == largest))
+                {
+                    continue;
+                }
+                work->queue[tail] = piece;
+                tail = (tail + 1) % capacity;
+                work->in_queue[piece] = true;
+            }
+        }
+
+        for (int i = 0; i < numTouched; i++)
+        {
+            work->count[work->touched[i]] = 0;
+        }
+
+        if (symmetry.steps > symmetry.budget)
+        {
+            while (head != tail)
+            {
+                work->in_queue[work->queue[head]] = false;
+                head = (head + 1) % capacity;
+            }
+            return 0;
+        }
+    }
+
+    return fingerprint ^ (uint64_t)p->numCells;
+}
+
+// Make node its own cell (placed first) and refine
+uint64_t sym_individualize(const SymGraph *graph, SymPartition *p, SymWork *work, int node)
+{
+    int s = p->cell_of[node];
+    int end = p->cell_end[s];
+    for (int i = s; i < end; i++)
+    {
+        if (p->lab[i] == node)
+        {
+            p->lab[i] = p->lab[s];
+            p->lab[s] = node;
+            break;
+        }
+    }
+
+    p->cell_end[s] = s + 1;
+    p->cell_end[s + 1] = end;
+    for (int i = s + 1; i < end; i++)
+    {
+        p->cell_of[p->lab[i]] = s + 1;
+    }
+    p->numCells++;
+
+    return sym_refine(graph, p, work, &s, 1);
+}
+
+// First cell with more than one node, -1 when the partition is discrete
+int sym_target_cell(const SymPartition *p)
+{
+    for (int i = 0; i < p->numNodes; i = p->cell_end[i])
+    {
+        if (p->cell_end[i] - i > 1)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool sym_is_automorphism(const SymGraph *graph, const int *perm, int *mark)
+{
+    for (int u = 0; u < graph->numNodes; u++)
+    {
+        int pu = perm[u];
+        if (graph->adj_start[u + 1] - graph->adj_start[u] != graph->adj_start[pu + 1] - graph->adj_start[pu])
+        {
+            return false;
+        }
+
+        for (int e = graph->adj_start[pu]; e < graph->adj_start[pu + 1]; e++)
+        {
+            mark[graph->adj[e]] = u + 1;
+        }
+        for (int e = graph->adj_start[u]; e < graph->adj_start[u + 1]; e++)
+        {
+            if (mark[perm[graph->adj[e]]] != u + 1)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int sym_find(int *parent, int x)
+{
+    while (parent[x] != x)
+    {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// Depth-first search for a leaf below right whose fingerprints match the first
+// path at every level, and whose node order maps the first leaf by an automorphism
+bool sym_search(SymSearch *search, int level, SymPartition *right)
+{
+    if (symmetry.steps > symmetry.budget)
+    {
+        return false;
+    }
+
+    if (level == search->depth)
+    {
+        for (int i = 0; i < search->graph->numNodes; i++)
+        {
+            search->perm[search->leaf->lab[i]] = right->lab[i];
+        }
+        return sym_is_automorphism(search->graph, search->perm, search->mark);
+    }
+
+    int t = search->target[level];
+    int end = right->cell_end[t];
+    if (right->cell_of[right->lab[t]] != t || end - t != search->path[level]->cell_end[t] - t)
+    {
+        return false;
+    }
+
+    // Try the node the first path chose before the others
+    int *order = malloc(sizeof(int) * (end - t));
+    int count = 0;
+    for (int i = t; i < end; i++)
+    {
+        if (right->lab[i] == search->chosen[level])
+        {
+            order[count++] = right->lab[i];
+        }
+    }
+    for (int i = t; i < end; i++)
+    {
+        if (right->lab[i] != search->chosen[level])
+        {
+            order[count++] = right->lab[i];
+        }
+    }
+
+    bool found = false;
+    for (int i = 0; i < count && !found && symmetry.steps <= symmetry.budget; i++)
+    {
+        SymPartition *next = search->right[level + 1];
+        sym_partition_copy(next, right);
+        found = sym_individualize(search->graph, next, search->work, order[i]) == search->fingerprint[level] &&
+                sym_search(search, level + 1, next);
+    }
+
+    free(order);
+    return found;
+}
+
+// Generators of the automorphism group by individualization-refinement: a first
+// path down to a discrete partition, then for every level from the bottom up and
+// every other node of its target cell, a search for an automorphism fixing the
+// nodes chosen above and mapping the chosen node there. Nodes already in the
+// chosen node's orbit are skipped. Returns the generators as literal node maps.
+GPtrArray *find_symmetry_generators(const SymGraph *graph)
+{
+    GPtrArray *generators = g_ptr_array_new_with_free_func(free);
+    int n = graph->numNodes;
+
+    SymWork work;
+    work.count = calloc(n, sizeof(int));
+    work.touched = malloc(sizeof(int) * n);
+    work.cells = malloc(sizeof(int) * n);
+    work.cell_mark = calloc(n, sizeof(bool));
+    work.queue = malloc(sizeof(int) * (n + 1));
+    work.in_queue = calloc(n, sizeof(bool));
+
+    // Initial partition by color, literals first
+    SymPartition *root = sym_partition_new(n);
+    int splitters[2], numSplitters = 0;
+    int pos = 0;
+    for (int color = 0; color <= 1; color++)
+    {
+        int start = pos;
+        for (int v = 0; v < n; v++)
+        {
+            if (graph->color[v] == color)
+            {
+                root->lab[pos] = v;
+                root->cell_of[v] = start;
+                pos++;
+            }
+        }
+        if (pos > start)
+        {
+            root->cell_end[start] = pos;
+            root->numCells++;
+            splitters[numSplitters++] = start;
+        }
+    }
+
+    SymSearch search;
+    search.graph = graph;
+    search.work = &work;
+    search.perm = malloc(sizeof(int) * n);
+    search.mark = calloc(n, sizeof(int));
+    search.depth = 0;
+
+    // Levels are bounded by the number of nodes; arrays grow with the first path
+    int capacity = 16;
+    search.path = malloc(sizeof(SymPartition *) * capacity);
+    search.target = malloc(sizeof(int) * capacity);
+    search.chosen = malloc(sizeof(int) * capacity);
+    search.fingerprint = malloc(sizeof(uint64_t) * capacity);
+
+    bool ok = sym_refine(graph, root, &work, splitters, numSplitters) != 0;
+    SymPartition *current = root;
+    while (ok)
+    {
+        int t = sym_target_cell(current);
+        if (t < 0)
+        {
+            break;
+        }
+
+        // Every level keeps a partition (and a second one for the searches)
+        if ((size_t)(search.depth + 1) * n > SYM_MAX_PATH_ENTRIES)
+        {
+            symmetry.steps = symmetry.budget + 1;
+            ok = false;
+            break;
+        }
+
+        if (search.depth == capacity)
+        {
+            capacity *= 2;
+            search.path = realloc(search.path, sizeof(SymPartition *) * capacity);
+            search.target = realloc(search.target, sizeof(int) * capacity);
+            search.chosen = realloc(search.chosen, sizeof(int) * capacity);
+            search.fingerprint = realloc(search.fingerprint, sizeof(uint64_t) * capacity);
+        }
+
+        int level = search.depth++;
+        search.path[level] = current;
+        search.target[level] = t;
+        search.chosen[level] = current->lab[t];
+
+        SymPartition *next = sym_partition_new(n);
+        sym_partition_copy(next, current);
+        search.fingerprint[level] = sym_individualize(graph, next, &work, search.chosen[level]);
+        ok = search.fingerprint[level] != 0;
+        current = next;
+    }
+    search.leaf = current;
+
+    if (ok)
+    {
+        search.right = malloc(sizeof(SymPartition *) * (search.depth + 1));
+        for (int level = 0; level <= search.depth; level++)
+        {
+            search.right[level] = sym_partition_new(n);
+        }
+
+        int *orbit = malloc(sizeof(int) * n);
+        for (int v = 0; v < n; v++)
+        {
+            orbit[v] = v;
+        }
+
+        for (int level = search.depth - 1; level >= 0 && symmetry.steps <= symmetry.budget; level--)
+        {
+            SymPartition *p = search.path[level];
+            int t = search.target[level];
+            int chosen = search.chosen[level];
+            for (int i = t + 1; i < p->cell_end[t]; i++)
+            {
+                int w = p->lab[i];
+                if (sym_find(orbit, w) == sym_find(orbit, chosen))
+                {
+                    continue;
+                }
+                if (symmetry.max_generators && (int)generators->len >= symmetry.max_generators)
+                {
+                    break;
+                }
+
+                SymPartition *right = search.right[level + 1];
+                sym_partition_copy(right, p);
+                if (sym_individualize(graph, right, &work, w) != search.fingerprint[level] ||
+                    !sym_search(&search, level + 1, right))
+                {
+                    if (symmetry.steps > symmetry.budget)
+                    {
+                        break;
+                    }
+                    continue;
+                }
+
+                // Orbits of the group found so far, over all nodes
+                for (int v = 0; v < n; v++)
+                {
+                    int a = sym_find(orbit, v), b = sym_find(orbit, search.perm[v]);
+                    if (a != b)
+                    {
+                        orbit[a] = b;
+                    }
+                }
+
+                // Only the literal part matters for the clauses; identity there
+                // means two identical clauses swapped
+                bool moves_literal = false;
+                for (int v = 0; v < graph->numLitNodes && !moves_literal; v++)
+                {
+                    moves_literal = search.perm[v] != v;
+                }
+                if (moves_literal)
+                {
+                    int *generator = malloc(sizeof(int) * graph->numLitNodes);
+                    memcpy(generator, search.perm, sizeof(int) * graph->numLitNodes);
+                    g_ptr_array_add(generators, generator);
+                }
+            }
+        }
+
+        free(orbit);
+        for (int level = 0; level <= search.depth; level++)
+        {
+            sym_partition_free(search.right[level]);
+        }
+        free(search.right);
+    }
+
+    symmetry.exhausted = symmetry.steps > symmetry.budget;
+
+    for (int level = 0; level < search.depth; level++)
+    {
+        sym_partition_free(search.path[level]);
+    }
+    sym_partition_free(current);
+    free(search.path);
+    free(search.target);
+    free(search.chosen);
+    free(search.fingerprint);
+    free(search.perm);
+    free(search.mark);
+    free(work.count);
+    free(work.touched);
+    free(work.cells);
+    free(work.cell_mark);
+    free(work.queue);
+    free(work.in_queue);
+
+    return generators;
+}
+
+void add_clause(Formula *formula, int *capacity, const int *lits, int size)
+{
+    if (formula->numClauses == *capacity)
+    {
+        *capacity = *capacity * 2 + 16;
+        formula->clauses = realloc(formula->clauses, sizeof(Clause) * *capacity);
+    }
+
+    Clause *clause = &formula->clauses[formula->numClauses++];
+    clause->size = 0;
+    clause->satisfied = false;
+    clause->literals = malloc(sizeof(Literal) * size);
+    for (int i = 0; i < size; i++)
+    {
+        if (lits[i] != 0)
+        {
+            clause->literals[clause->size].var = abs(lits[i]);
+            clause->literals[clause->size].neg = lits[i] < 0;
+            clause->size++;
+        }
+    }
+    remove_duplicate_literals(clause);
+}
+
+// Lex-leader predicate x <= sigma(x) over the variables moved by the generator,
+// taken in the given order (0-terminated), with Aloul et al.'s encoding: p_j means the first j moved
+// variables equal their images, and per variable
+//   (-p_{j-1} | -x_j | y_j), (-p_{j-1} | -x_j | p_j), (-p_{j-1} | y_j | p_j)
+// where y_j is the image literal. The chain stops after a variable mapped to its
+// own negation (x_j must then be false) and after max_chain variables; a prefix
+// of the lex constraint is still implied by the full one.
+void add_lex_leader(Formula *formula, int *capacity, const int *generator, const int *order)
+{
+    int prev = 0; // p_{j-1}, 0 for true
+    int length = 0;
+    int last = 0;
+    for (int i = 0; order[i] != 0; i++)
+    {
+        if (generator[2 * (order[i] - 1)] != 2 * (order[i] - 1))
+        {
+            last = order[i];
+        }
+    }
+
+    for (int i = 0; last != 0 && order[i] != 0; i++)
+    {
+        int v = order[i];
+        int image = generator[2 * (v - 1)];
+        if (image == 2 * (v - 1))
+        {
+            continue;
+        }
+        if (symmetry.max_chain && length == symmetry.max_chain)
+        {
+            break;
+        }
+        length++;
+
+        int y = (image & 1) ? -(image / 2 + 1) : image / 2 + 1;
+        int less[3] = {-prev, -v, y};
+        add_clause(formula, capacity, less, 3);
+        symmetry.clauses_added++;
+
+        if (y == -v || v == last || (symmetry.max_chain && length == symmetry.max_chain))
+        {
+            break;
+        }
+
+        int p = ++formula->numVars;
+        symmetry.aux_vars++;
+        int equal_true[3] = {-prev, -v, p};
+        int equal_false[3] = {-prev, y, p};
+        add_clause(formula, capacity, equal_true, 3);
+        add_clause(formula, capacity, equal_false, 3);
+        symmetry.clauses_added += 2;
+        prev = p;
+    }
+}
+
+// Detect symmetries of the formula and add lex-leader clauses for every
+// generator, comparing variables in the decision order. Variables after its 0
+// terminator have no occurrences and come last, so leaving them out only
+// shortens the constraints. New auxiliary
+// variables are numbered after the original ones.
+void add_symmetry_breaking(Formula *formula, const int *order)
+{
+    SymGraph *graph = build_symmetry_graph(formula);
+    GPtrArray *generators = find_symmetry_generators(graph);
+    symmetry.generators = generators->len;
+
+    int capacity = formula->numClauses;
+    for (guint i = 0; i < generators->len; i++)
+    {
+        add_lex_leader(formula, &capacity, g_ptr_array_index(generators, i), order);
+    }
+    formula->clauses = realloc(formula->clauses, sizeof(Clause) * formula->numClauses);
+
+    g_ptr_array_free(generators, TRUE);
+    free_symmetry_graph(graph);
+}
+
+// Backbone
+
+// Watch a clause added after the watch table was built
+void watch_clause(WatchTable *wtable, Formula *formula, int index)
+{
+    Clause *clause = &formula->clauses[index];
+    for (int i = 0; i < clause->size && i < 2; i++)
+    {
+        GArray *arr = wtable->watch_lists[watchlist_index(clause->literals[i], formula->numVars)];
+        g_array_append_val(arr, index);
+    }
+}
+
+// Drop the last clause and its watches. The undo stack must be unwound first,
+// the watches are then on the literals watch_clause chose.
+void remove_last_clause(Formula *formula, WatchTable *wtable)
+{
+    int index = --formula->numClauses;
+    Clause *clause = &formula->clauses[index];
+    for (int i = 0; i < clause->size && i < 2; i++)
+    {
+        GArray *arr = wtable->watch_lists[watchlist_index(clause->literals[i], formula->numVars)];
+        for (guint j = 0; j < arr->len; j++)
+        {
+            if (g_array_index(arr, int, j) == index)
+            {
+                g_array_remove_index(arr, j);
+                break;
+            }
+        }
+    }
+    free(clause->literals);
+}
+
+// Backbone of a satisfiable formula, starting from the model in assignments.
+// Every candidate is a literal of the last model. A query adds the clause "one
+// of the next chunk candidates is false": UNSAT confirms the whole chunk, which
+// is then kept as unit clauses, and a model drops every candidate it falsifies,
+// inside the chunk or not. The chunk doubles after UNSAT and halves after SAT.
+// Unassigned variables in a model can take either value and are never backbone.
+// The same formula, watch table and undo stack serve all queries; the added
+// clauses are removed again before returning. Returns SAT once every candidate
+// is decided and TIMEOUT if a limit stopped a query.
+DPLLReturnType compute_backbone(Formula *formula, int *assignments, UndoStack *stack, WatchTable *wtable, int numVars)
+{
+    int *candidates = malloc(sizeof(int) * (numVars + 1));
+    int count = 0;
+    for (int var = 1; var <= numVars; var++)
+    {
+        if (assignments[var] != -1)
+        {
+            candidates[count++] = assignments[var] ? var : -var;
+        }
+    }
+    undo_to_checkpoint(stack, NULL, formula, assignments, wtable);
+
+    free(backbone.literals);
+    backbone.literals = malloc(sizeof(int) * (count + 1));
+    backbone.size = 0;
+    backbone.queries = 1; // The first solve
+    backbone.sat_queries = 1;
+    backbone.unsat_queries = 0;
+
+    int numClausesBase = formula->numClauses;
+    int capacity = formula->numClauses;
+    int chunk = backbone.chunk;
+    int *lits = malloc(sizeof(int) * (count + 1));
+    DPLLReturnType result = SAT;
+
+    while (count > 0)
+    {
+        int k = chunk < count ? chunk : count;
+        for (int i = 0; i < k; i++)
+        {
+            lits[i] = -candidates[count - 1 - i];
+        }
+        add_clause(formula, &capacity, lits, k);
+        watch_clause(wtable, formula, formula->numClauses - 1);
+
+        backbone.queries++;
+        result = dpll(formula, assignments, stack, wtable, 0);
+        if (result == TIMEOUT)
+        {
+            undo_to_checkpoint(stack, NULL, formula, assignments, wtable);
+            remove_last_clause(formula, wtable);
+            break;
+        }
+
+        if (result == UNSAT)
+        {
+            backbone.unsat_queries++;
+            undo_to_checkpoint(stack, NULL, formula, assignments, wtable);
+            remove_last_clause(formula, wtable);
+            for (int i = 0; i < k; i++)
+            {
+                int lit = candidates[--count];
+                backbone.literals[backbone.size++] = lit;
+                add_clause(formula, &capacity, &lit, 1);
+                watch_clause(wtable, formula, formula->numClauses - 1);
+            }
+            chunk *= 2;
+        }
+        else
+        {
+            backbone.sat_queries++;
+            int kept = 0;
+            for (int i = 0; i < count; i++)
+            {
+                int var = abs(candidates[i]);
+                if (assignments[var] == (candidates[i] > 0))
+                {
+                    candidates[kept++] = candidates[i];
+                }
+            }
+            count = kept;
+            undo_to_checkpoint(stack, NULL, formula, assignments, wtable);
+            remove_last_clause(formula, wtable);
+            chunk = chunk > 1 ? chunk / 2 : 1;
+        }
+    }
+
+    while (formula->numClauses > numClausesBase)
+    {
+        remove_last_clause(formula, wtable);
+    }
+
+    backbone.candidates = result == TIMEOUT ? count : 0;
+    free(lits);
+    free(candidates);
+    return result == TIMEOUT ? TIMEOUT : SAT;
+}
+
+int compare_var(const void *a, const void *b)
+{
+    return abs(*(const int *)a) - abs(*(const int *)b);
+}
+
+// Backbone literals by variable as "b ... 0" lines, in the style of the v lines
+void print_backbone()
+{
+    qsort(backbone.literals, backbone.size, sizeof(int), compare_var);
+    printf("b");
+    for (int i = 0; i < backbone.size; i++)
+    {
+        printf(" %d", backbone.literals[i]);
+        if ((i + 1) % 20 == 0 && i + 1 < backbone.size)
+        {
+            printf("\nb");
+        }
+    }
+    printf(" 0\n");
+}
+
+// Community detection
+
+// Variable incidence graph: an edge between every two variables sharing a
+// clause, weighted 1 / (k choose 2) per clause of k literals so that every
+// clause adds the same total weight
+WeightedGraph *build_variable_graph(Formula *formula)
+{
+    int n = formula->numVars;
+
+    // Clauses per variable, each clause once
+    int *occ_start = calloc(n + 2, sizeof(int));
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        for (int j = 0; j < formula->clauses[i].size; j++)
+        {
+            occ_start[formula->clauses[i].literals[j].var + 1]++;
+        }
+    }
+    for (int v = 1; v <= n + 1; v++)
+    {
+        occ_start[v] += occ_start[v - 1];
+    }
+    int *occ = malloc(sizeof(int) * (occ_start[n + 1] + 1));
+    int *fill = malloc(sizeof(int) * (n + 1));
+    memcpy(fill, occ_start, sizeof(int) * (n + 1));
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        for (int j = 0; j < formula->clauses[i].size; j++)
+        {
+            int var = formula->clauses[i].literals[j].var;
+            if (fill[var] == occ_start[var] || occ[fill[var] - 1] != i)
+            {
+                occ[fill[var]++] = i;
+            }
+        }
+    }
+
+    WeightedGraph *graph = malloc(sizeof(WeightedGraph));
+    graph->numNodes = n;
+    graph->adj_start = malloc(sizeof(int) * (n + 1));
+    graph->self_weight = calloc(n > 0 ? n : 1, sizeof(double));
+    int capacity = 1024, numEdges = 0;
+    graph->adj = malloc(sizeof(int) * capacity);
+    graph->weight = malloc(sizeof(double) * capacity);
+
+    // Accumulate each node's row in a dense array
+    double *acc = calloc(n + 1, sizeof(double));
+    int *touched = malloc(sizeof(int) * (n + 1));
+    for (int u = 1; u <= n; u++)
+    {
+        int numTouched = 0;
+        for (int o = occ_start[u]; o < fill[u]; o++)
+        {
+            Clause *clause = &formula->clauses[occ[o]];
+            if (clause->size < 2 || clause->size > COMMUNITY_MAX_CLAUSE)
+            {
+                continue;
+            }
+            double w = 2.0 / ((double)clause->size * (clause->size - 1));
+            for (int j = 0; j < clause->size; j++)
+            {
+                int v = clause->literals[j].var;
+                if (v == u)
+                {
+                    continue;
+                }
+                if (acc[v] == 0.0)
+                {
+                    touched[numTouched++] = v;
+                }
+                acc[v] += w;
+            }
+        }
+
+        graph->adj_start[u - 1] = numEdges;
+        if (numEdges + numTouched > capacity)
+        {
+            capacity = (numEdges + numTouched) * 2;
+            graph->adj = realloc(graph->adj, sizeof(int) * capacity);
+            graph->weight = realloc(graph->weight, sizeof(double) * capacity);
+        }
+        for (int i = 0; i < numTouched; i++)
+        {
+            graph->adj[numEdges] = touched[i] - 1;
+            graph->weight[numEdges++] = acc[touched[i]];
+            acc[touched[i]] = 0.0;
+        }
+    }
+    graph->adj_start[n] = numEdges;
+
+    free(touched);
+    free(acc);
+    free(fill);
+    free(occ);
+    free(occ_start);
+    return graph;
+}
+
+void free_weighted_graph(WeightedGraph *graph)
+{
+    free(graph->adj_start);
+    free(graph->adj);
+    free(graph->weight);
+    free(graph->self_weight);
+    free(graph);
+}
+
+// Weighted degree, with the inner edges of an aggregated node counted from both ends
+double node_degree(const WeightedGraph *graph, int u)
+{
+    double degree = 2.0 * graph->self_weight[u];
+    for (int e = graph->adj_start[u]; e < graph->adj_start[u + 1]; e++)
+    {
+        degree += graph->weight[e];
+    }
+    return degree;
+}
+
+// First Louvain phase: starting from singletons, move nodes to the neighbouring
+// community with the largest modularity gain until no move helps. Nodes are
+// visited in index order, so the result is deterministic. Communities are
+// renumbered from 0; returns their number.
+int louvain_local_moves(const WeightedGraph *graph, int *community)
+{
+    int n = graph->numNodes;
+    double *degree = malloc(sizeof(double) * (n > 0 ? n : 1));
+    double *total = malloc(sizeof(double) * (n > 0 ? n : 1));
+    double *link = calloc(n > 0 ? n : 1, sizeof(double));
+    int *touched = malloc(sizeof(int) * (n > 0 ? n : 1));
+    double m2 = 0.0;
+    for (int u = 0; u < n; u++)
+    {
+        degree[u] = node_degree(graph, u);
+        total[u] = degree[u];
+        community[u] = u;
+        m2 += degree[u];
+    }
+
+    bool moved = m2 > 0.0;
+    for (int pass = 0; moved && pass < 100; pass++)
+    {
+        moved = false;
+        for (int u = 0; u < n; u++)
+        {
+            if (degree[u] == 0.0)
+            {
+                continue;
+            }
+
+            int numTouched = 0;
+            for (int e = graph->adj_start[u]; e < graph->adj_start[u + 1]; e++)
+            {
+                int c = community[graph->adj[e]];
+                if (link[c] == 0.0)
+                {
+                    touched[numTouched++] = c;
+                }
+                link[c] += graph->weight[e];
+            }
+
+            // Gain of joining c: link to c minus the expected link total[c] * degree / 2m
+            int old = community[u];
+            total[old] -= degree[u];
+            int best = old;
+            double best_gain = link[old] - total[old] * degree[u] / m2;
+            for (int i = 0; i < numTouched; i++)
+            {
+                int c = touched[i];
+                double gain = link[c] - total[c] * degree[u] / m2;
+                if (gain > best_gain + 1e-12)
+                {
+                    best = c;
+                    best_gain = gain;
+                }
+            }
+            total[best] += degree[u];
+            community[u] = best;
+            moved |= best != old;
+
+            for (int i = 0; i < numTouched; i++)
+            {
+                link[touched[i]] = 0.0;
+            }
+        }
+    }
+
+    // Renumber in order of first appearance
+    int *renumber = malloc(sizeof(int) * (n > 0 ? n : 1));
+    for (int u = 0; u < n; u++)
+    {
+        renumber[u] = -1;
+    }
+    int count = 0;
+    for (int u = 0; u < n; u++)
+    {
+        if (renumber[community[u]] < 0)
+        {
+            renumber[community[u]] = count++;
+        }
+        community[u] = renumber[community[u]];
+    }
+
+    free(renumber);
+    free(touched);
+    free(link);
+    free(total);
+    free(degree);
+    return count;
+}
+
+// Second Louvain phase: one node per community, edges summed between
+// communities, and edges inside a community added to its self weight
+WeightedGraph *aggregate_graph(const WeightedGraph *graph, const int *community, int numCommunities)
+{
+    int n = graph->numNodes;
+    int *member_start = calloc(numCommunities + 1, sizeof(int));
+    for (int u = 0; u < n; u++)
+    {
+        member_start[community[u] + 1]++;
+    }
+    for (int c = 0; c < numCommunities; c++)
+    {
+        member_start[c + 1] += member_start[c];
+    }
+    int *members = malloc(sizeof(int) * (n > 0 ? n : 1));
+    int *fill = malloc(sizeof(int) * (numCommunities + 1));
+    memcpy(fill, member_start, sizeof(int) * (numCommunities + 1));
+    for (int u = 0; u < n; u++)
+    {
+        members[fill[community[u]]++] = u;
+    }
+
+    WeightedGraph *next = malloc(sizeof(WeightedGraph));
+    next->numNodes = numCommunities;
+    next->adj_start = malloc(sizeof(int) * (numCommunities + 1));
+    next->self_weight = calloc(numCommunities > 0 ? numCommunities : 1, sizeof(double));
+    int capacity = graph->adj_start[n] + 1, numEdges = 0;
+    next->adj = malloc(sizeof(int) * capacity);
+    next->weight = malloc(sizeof(double) * capacity);
+
+    double *acc = calloc(numCommunities > 0 ? numCommunities : 1, sizeof(double));
+    int *touched = malloc(sizeof(int) * (numCommunities > 0 ? numCommunities : 1));
+    for (int c = 0; c < numCommunities; c++)
+    {
+        int numTouched = 0;
+        for (int m = member_start[c]; m < member_start[c + 1]; m++)
+        {
+            int u = members[m];
+            next->self_weight[c] += graph->self_weight[u];
+            for (int e = graph->adj_start[u]; e < graph->adj_start[u + 1]; e++)
+            {
+                int d = community[graph->adj[e]];
+                if (d == c)
+                {
+                    next->self_weight[c] += graph->weight[e] / 2.0; // Seen from both ends
+                    continue;
+                }
+                if (acc[d] == 0.0)
+                {
+                    touched[numTouched++] = d;
+                }
+                acc[d] += graph->weight[e];
+            }
+        }
+
+        next->adj_start[c] = numEdges;
+        for (int i = 0; i < numTouched; i++)
+        {
+            next->adj[numEdges] = touched[i];
+            next->weight[numEdges++] = acc[touched[i]];
+            acc[touched[i]] = 0.0;
+        }
+    }
+    next->adj_start[numCommunities] = numEdges;
+
+    free(touched);
+    free(acc);
+    free(fill);
+    free(members);
+    free(member_start);
+    return next;
+}
+
+// Louvain method: local moves and aggregation until a level moves nothing.
+// membership receives the community of every node of graph; returns the
+// aggregated graph of the communities and records modularity and levels.
+WeightedGraph *detect_communities(const WeightedGraph *graph, int *membership)
+{
+    int n = graph->numNodes;
+    int *community = malloc(sizeof(int) * (n > 0 ? n : 1));
+    for (int u = 0; u < n; u++)
+    {
+        membership[u] = u;
+    }
+
+    WeightedGraph *current = aggregate_graph(graph, membership, n);
+    communities.levels = 0;
+    while (true)
+    {
+        int count = louvain_local_moves(current, community);
+        if (count == current->numNodes)
+        {
+            break;
+        }
+
+        communities.levels++;
+        for (int u = 0; u < n; u++)
+        {
+            membership[u] = community[membership[u]];
+        }
+        WeightedGraph *next = aggregate_graph(current, community, count);
+        free_weighted_graph(current);
+        current = next;
+    }
+
+    // Q = sum over communities of inner / 2m - (degree / 2m)^2
+    double m2 = 0.0;
+    for (int c = 0; c < current->numNodes; c++)
+    {
+        m2 += node_degree(current, c);
+    }
+    communities.modularity = 0.0;
+    communities.count = 0;
+    for (int c = 0; c < current->numNodes && m2 > 0.0; c++)
+    {
+        double degree = node_degree(current, c);
+        communities.modularity += 2.0 * current->self_weight[c] / m2 - (degree / m2) * (degree / m2);
+        communities.count += degree > 0.0;
+    }
+
+    free(community);
+    return current;
+}
+
+typedef struct
+{
+    const int *rank;
+    const int *counter;
+} CommunityKey;
+
+// By community rank, then by occurrences (descending), then by variable
+int compare_community(const void *a, const void *b, void *key)
+{
+    const CommunityKey *k = key;
+    int x = *(const int *)a, y = *(const int *)b;
+    if (k->rank[x] != k->rank[y])
+    {
+        return k->rank[x] - k->rank[y];
+    }
+    if (k->counter[x] != k->counter[y])
+    {
+        return k->counter[y] - k->counter[x];
+    }
+    return x - y;
+}
+
+// Decision order that finishes one community before moving to the next. The
+// first community is the one with the most occurrences; each next one is the
+// community most strongly connected to those already placed (most occurrences
+// if none is connected). Within a community variables go by occurrences, so the
+// search stays inside one module until it is decided. Variables without
+// occurrences follow the 0 terminator, as in occurrence_order.
+int *community_order(Formula *formula)
+{
+    int n = formula->numVars;
+    int *counter = calloc(n + 1, sizeof(int));
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        for (int j = 0; j < formula->clauses[i].size; j++)
+        {
+            counter[formula->clauses[i].literals[j].var]++;
+        }
+    }
+
+    WeightedGraph *graph = build_variable_graph(formula);
+    int *membership = malloc(sizeof(int) * (n > 0 ? n : 1));
+    WeightedGraph *reduced = detect_communities(graph, membership);
+    int k = reduced->numNodes;
+
+    long *score = calloc(k > 0 ? k : 1, sizeof(long));
+    for (int v = 1; v <= n; v++)
+    {
+        score[membership[v - 1]] += counter[v];
+    }
+
+    // Greedy placement of the communities by connection to the placed ones
+    int *community_rank = malloc(sizeof(int) * (k > 0 ? k : 1));
+    double *connection = calloc(k > 0 ? k : 1, sizeof(double));
+    for (int c = 0; c < k; c++)
+    {
+        community_rank[c] = -1;
+    }
+    for (int placed = 0; placed < k; placed++)
+    {
+        int best = -1;
+        for (int c = 0; c < k; c++)
+        {
+            if (community_rank[c] >= 0)
+            {
+                continue;
+            }
+            if (best < 0 || connection[c] > connection[best] ||
+                (connection[c] == connection[best] && score[c] > score[best]))
+            {
+                best = c;
+            }
+        }
+        community_rank[best] = placed;
+        for (int e = reduced->adj_start[best]; e < reduced->adj_start[best + 1]; e++)
+        {
+            connection[reduced->adj[e]] += reduced->weight[e];
+        }
+    }
+
+    int *rank = malloc(sizeof(int) * (n + 1));
+    rank[0] = 0;
+    for (int v = 1; v <= n; v++)
+    {
+        rank[v] = community_rank[membership[v - 1]];
+    }
+
+    int *order = malloc(sizeof(int) * (n + 1));
+    int size = 0;
+    for (int v = 1; v <= n; v++)
+    {
+        if (counter[v] > 0)
+        {
+            order[size++] = v;
+        }
+    }
+    CommunityKey key = {rank, counter};
+    qsort_r(order, size, sizeof(int), compare_community, &key);
+    order[size++] = 0;
+    for (int v = 1; v <= n; v++)
+    {
+        if (counter[v] == 0)
+        {
+            order[size++] = v;
+        }
+    }
+
+    free(rank);
+    free(connection);
+    free(community_rank);
+    free(score);
+    free_weighted_graph(reduced);
+    free_weighted_graph(graph);
+    free(membership);
+    free(counter);
+    return order;
+}
+
+// Instance features and configuration selection
+
+// Short DPLL run in the occurrence order with its own watch table and state,
+// which is unwound afterwards: propagations and conflicts per decision, and
+// whether it already finished. The counters and limits of the real run are
+// restored. Without SAT_STATS there is no decision limit and the probe is skipped.
+void probe_features(Formula *formula, double *features)
+{
+    features[FEATURE_PROBE_PROPAGATIONS] = 0.0;
+    features[FEATURE_PROBE_CONFLICTS] = 0.0;
+    features[FEATURE_PROBE_SOLVED] = 0.0;
+    if (!SAT_STATS)
+    {
+        return;
+    }
+
+    SolverStats saved_stats = stats;
+    Limits saved_limits = limits;
+    int *saved_sort = var_sort;
+    unsigned char *saved_branch = branch_state;
+    int *saved_path = decision_path;
+
+    memset(&stats, 0, sizeof(stats));
+    limits = (Limits){0.0, 0.0, PROBE_DECISIONS, 0, 0, saved_limits.check_interval};
+    var_sort = occurrence_order(formula);
+    branch_state = calloc(formula->numVars + 2, sizeof(unsigned char));
+    decision_path = calloc(formula->numVars + 2, sizeof(int));
+    WatchTable *wtable = build_watch_table(formula);
+    int *assignments = malloc(sizeof(int) * (formula->numVars + 1));
+    for (int i = 0; i <= formula->numVars; i++)
+    {
+        assignments[i] = -1;
+    }
+    UndoStack stack = {NULL};
+
+    DPLLReturnType result = dpll(formula, assignments, &stack, wtable, 0);
+    undo_to_checkpoint(&stack, NULL, formula, assignments, wtable);
+
+    double decisions = stats.decisions > 0 ? (double)stats.decisions : 1.0;
+    features[FEATURE_PROBE_PROPAGATIONS] = log1p(stats.propagations / decisions);
+    features[FEATURE_PROBE_CONFLICTS] = stats.conflicts / decisions;
+    features[FEATURE_PROBE_SOLVED] = result != TIMEOUT;
+
+    free(assignments);
+    free_watchtable(wtable);
+    free(decision_path);
+    free(branch_state);
+    free(var_sort);
+    var_sort = saved_sort;
+    branch_state = saved_branch;
+    decision_path = saved_path;
+    stats = saved_stats;
+    limits = saved_limits;
+    limit_reached = LIMIT_NONE;
+    clock_check_countdown = 0;
+    search_depth = 0;
+}
+
+// Syntactic features in one pass over the clauses, the modularity, then the probe. Counts are
+// taken on a log scale and everything else as fractions, so that instances of
+// different sizes are comparable.
+void extract_features(Formula *formula, double *features)
+{
+    int n = formula->numVars, m = formula->numClauses;
+    int *degree = calloc(n + 1, sizeof(int));
+    long literals = 0, positive = 0;
+    int sizes[5] = {0, 0, 0, 0, 0}; // 1, 2, 3, 4-7, 8+
+    int horn = 0;
+
+    for (int i = 0; i < m; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        int pos = 0;
+        for (int j = 0; j < clause->size; j++)
+        {
+            degree[clause->literals[j].var]++;
+            pos += !clause->literals[j].neg;
+        }
+        literals += clause->size;
+        positive += pos;
+        horn += pos <= 1;
+
+        int k = clause->size;
+        sizes[k <= 1 ? 0 : k == 2 ? 1 : k == 3 ? 2 : k < 8 ? 3 : 4]++;
+    }
+
+    // Degree statistics over the variables that occur
+    int occurring = 0, max_degree = 0;
+    double sum = 0.0, sum_sq = 0.0;
+    for (int v = 1; v <= n; v++)
+    {
+        if (degree[v] > 0)
+        {
+            occurring++;
+            sum += degree[v];
+            sum_sq += (double)degree[v] * degree[v];
+            max_degree = degree[v] > max_degree ? degree[v] : max_degree;
+        }
+    }
+    double mean = occurring > 0 ? sum / occurring : 0.0;
+    double variance = occurring > 0 ? sum_sq / occurring - mean * mean : 0.0;
+
+    double clauses = m > 0 ? m : 1;
+    features[FEATURE_LOG_VARS] = log1p(n);
+    features[FEATURE_LOG_CLAUSES] = log1p(m);
+    features[FEATURE_RATIO] = n > 0 ? (double)m / n : 0.0;
+    features[FEATURE_UNIT] = sizes[0] / clauses;
+    features[FEATURE_BINARY] = sizes[1] / clauses;
+    features[FEATURE_TERNARY] = sizes[2] / clauses;
+    features[FEATURE_SIZE_4_7] = sizes[3] / clauses;
+    features[FEATURE_SIZE_8_PLUS] = sizes[4] / clauses;
+    features[FEATURE_HORN] = horn / clauses;
+    features[FEATURE_POSITIVE] = literals > 0 ? (double)positive / literals : 0.0;
+    features[FEATURE_DEGREE_MEAN] = log1p(mean);
+    features[FEATURE_DEGREE_CV] = mean > 0 ? sqrt(variance > 0 ? variance : 0.0) / mean : 0.0;
+    features[FEATURE_DEGREE_MAX] = mean > 0 ? log(max_degree / mean) : 0.0;
+    free(degree);
+
+    // Modularity of the variable graph, without touching the reported communities
+    Communities saved_communities = communities;
+    WeightedGraph *graph = build_variable_graph(formula);
+    int *membership = malloc(sizeof(int) * (n > 0 ? n : 1));
+    free_weighted_graph(detect_communities(graph, membership));
+    features[FEATURE_MODULARITY] = communities.modularity;
+    communities = saved_communities;
+    free(membership);
+    free_weighted_graph(graph);
+
+    probe_features(formula, features);
+}
+
+void print_features(const double *features)
+{
+    printf("Features:");
+    for (int i = 0; i < NUM_FEATURES; i++)
+    {
+        printf(" %s=%.4f", feature_names[i], features[i]);
+    }
+    printf("\n");
+}
+
+int find_preset(const char *name)
+{
+    for (int i = 0; i < NUM_PRESETS; i++)
+    {
+        if (strcmp(name, presets[i].name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void apply_preset(int index)
+{
+    heuristic = presets[index].heuristic;
+    symmetry.enabled = presets[index].symmetry;
+}
+
+// Model file written by sat_selector: a header "config,<feature names>,par2_<preset
+// names>" and one line per training instance. Rows with unknown configurations
+// are skipped; a header that does not match feature_names and presets means the
+// model is from another version and is rejected.
+SelectorModel *load_selector_model(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    GString *header = g_string_new("config");
+    for (int i = 0; i < NUM_FEATURES; i++)
+    {
+        g_string_append_printf(header, ",%s", feature_names[i]);
+    }
+    for (int i = 0; i < NUM_PRESETS; i++)
+    {
+        g_string_append_printf(header, ",par2_%s", presets[i].name);
+    }
+    bool valid = getline(&line, &capacity, file) > 0 && strncmp(line, header->str, header->len) == 0 &&
+                 (line[header->len] == '\n' || line[header->len] == '\0');
+    g_string_free(header, TRUE);
+
+    SelectorModel *model = calloc(1, sizeof(SelectorModel));
+    int rows = 0;
+    while (valid && getline(&line, &capacity, file) > 0)
+    {
+        char *save = NULL;
+        char *name = strtok_r(line, ",\n", &save);
+        int preset = name ? find_preset(name) : -1;
+        if (preset < 0)
+        {
+            continue;
+        }
+
+        if (model->count == rows)
+        {
+            rows = rows * 2 + 16;
+            model->preset = realloc(model->preset, sizeof(int) * rows);
+            model->features = realloc(model->features, sizeof(double) * rows * NUM_FEATURES);
+            model->cost = realloc(model->cost, sizeof(double) * rows * NUM_PRESETS);
+        }
+        double *row = &model->features[model->count * NUM_FEATURES];
+        double *cost = &model->cost[model->count * NUM_PRESETS];
+        int i = 0;
+        for (char *tok; i < NUM_FEATURES + NUM_PRESETS && (tok = strtok_r(NULL, ",\n", &save)) != NULL; i++)
+        {
+            if (i < NUM_FEATURES)
+                row[i] = atof(tok);
+            else
+                cost[i - NUM_FEATURES] = atof(tok);
+        }
+        if (i == NUM_FEATURES + NUM_PRESETS)
+        {
+            model->preset[model->count++] = preset;
+        }
+    }
+
+    free(line);
+    fclose(file);
+    if (!valid)
+    {
+        free_selector_model(model);
+        return NULL;
+    }
+    selector_standardize(model);
+    return model;
+}
+
+void selector_standardize(SelectorModel *model)
+{
+    for (int f = 0; f < NUM_FEATURES; f++)
+    {
+        double sum = 0.0, sum_sq = 0.0;
+        for (int r = 0; r < model->count; r++)
+        {
+            double x = model->features[r * NUM_FEATURES + f];
+            sum += x;
+            sum_sq += x * x;
+        }
+        double mean = model->count > 0 ? sum / model->count : 0.0;
+        double variance = model->count > 0 ? sum_sq / model->count - mean * mean : 0.0;
+        model->mean[f] = mean;
+        model->scale[f] = variance > 1e-12 ? 1.0 / sqrt(variance) : 0.0; // Constant features do not count
+    }
+}
+
+// Preset with the lowest PAR-2 score on the SELECTOR_K nearest training rows,
+// as a geometric mean with inverse-distance weights. Weighing the scores rather
+// than counting best presets keeps a neighbour on which every preset was equally
+// fast from outvoting one on which a preset timed out; the logarithm keeps one
+// slow neighbour from outweighing speedups on the others. Row exclude is left out
+// (leave-one-out evaluation, -1 for none), and so are symmetry presets when
+// models must be kept. Returns -1 if no preset was run on any neighbour.
+int select_preset(const SelectorModel *model, const double *features, int exclude, bool allow_symmetry)
+{
+    int nearest[SELECTOR_K];
+    double distance[SELECTOR_K];
+    int found = 0;
+
+    for (int r = 0; r < model->count; r++)
+    {
+        if (r == exclude)
+        {
+            continue;
+        }
+
+        double d = 0.0;
+        for (int f = 0; f < NUM_FEATURES; f++)
+        {
+            double diff = (features[f] - model->features[r * NUM_FEATURES + f]) * model->scale[f];
+            d += diff * diff;
+        }
+
+        // Insertion into the sorted list of the k best
+        int pos = found < SELECTOR_K ? found++ : SELECTOR_K;
+        while (pos > 0 && distance[pos - 1] > d)
+        {
+            if (pos < SELECTOR_K)
+            {
+                nearest[pos] = nearest[pos - 1];
+                distance[pos] = distance[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < SELECTOR_K)
+        {
+            nearest[pos] = r;
+            distance[pos] = d;
+        }
+    }
+
+    int best = -1;
+    double best_score = 0.0;
+    for (int p = 0; p < NUM_PRESETS; p++)
+    {
+        if (!allow_symmetry && presets[p].symmetry)
+        {
+            continue;
+        }
+
+        double sum = 0.0, weights = 0.0;
+        for (int i = 0; i < found; i++)
+        {
+            double cost = model->cost[nearest[i] * NUM_PRESETS + p];
+            if (cost >= 0.0)
+            {
+                double w = 1.0 / (sqrt(distance[i]) + 1e-6);
+                sum += w * log(cost + 1e-3);
+                weights += w;
+            }
+        }
+        if (weights > 0.0 && (best < 0 || sum / weights < best_score))
+        {
+            best = p;
+            best_score = sum / weights;
+        }
+    }
+    return best;
+}
+
+void free_selector_model(SelectorModel *model)
+{
+    if (!model)
+        return;
+
+    free(model->preset);
+    free(model->features);
+    free(model->cost);
+    free(model);
+}
+
+// Result cache
+
+// Literal code 2 * var + neg, so that sorting puts x and -x next to each other
+static inline int literal_code(Literal lit)
+{
+    return 2 * lit.var + lit.neg;
+}
+
+typedef struct
+{
+    const int *codes;
+    const int *start;
+} CanonicalKey;
+
+// Lexicographic on the sorted literal codes, shorter prefix first
+int compare_canonical(const void *a, const void *b, void *key)
+{
+    const CanonicalKey *k = key;
+    int x = *(const int *)a, y = *(const int *)b;
+    int sx = k->start[x + 1] - k->start[x], sy = k->start[y + 1] - k->start[y];
+    for (int i = 0; i < sx && i < sy; i++)
+    {
+        int d = k->codes[k->start[x] + i] - k->codes[k->start[y] + i];
+        if (d != 0)
+        {
+            return d;
+        }
+    }
+    return sx - sy;
+}
+
+// Two independent 64-bit streams over the canonical words: FNV-1a on bytes and
+// a multiply-rotate mix on words, each finished with the splitmix64 finalizer
+static inline void hash_word(uint64_t *h, uint32_t word)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        h[0] = (h[0] ^ ((word >> (8 * i)) & 0xff)) * 0x100000001b3ULL;
+    }
+    uint64_t k = word * 0x87c37b91114253d5ULL;
+    k = (k << 31) | (k >> 33);
+    h[1] = (h[1] ^ k * 0x4cf5ad432745937fULL);
+    h[1] = ((h[1] << 27) | (h[1] >> 37)) * 5 + 0x52dce729;
+}
+
+static inline uint64_t hash_finish(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Canonical hash of the formula as parsed, into cache.key: literals are sorted
+// within each clause, tautologies dropped, clauses sorted and duplicates
+// dropped. The variable count is hashed too since models cover every variable.
+void formula_hash(Formula *formula)
+{
+    int m = formula->numClauses;
+    long total = 0;
+    for (int i = 0; i < m; i++)
+    {
+        total += formula->clauses[i].size;
+    }
+
+    int *codes = malloc(sizeof(int) * (total > 0 ? total : 1));
+    int *start = malloc(sizeof(int) * (m + 1));
+    int *order = malloc(sizeof(int) * (m > 0 ? m : 1));
+    int kept = 0, used = 0;
+    for (int i = 0; i < m; i++)
+    {
+        Clause *clause = &formula->clauses[i];
+        int begin = used;
+        for (int j = 0; j < clause->size; j++)
+        {
+            codes[used++] = literal_code(clause->literals[j]);
+        }
+        qsort(&codes[begin], used - begin, sizeof(int), compare_int);
+
+        // Drop repeated literals; a clause with x and -x is always satisfied
+        int size = 0;
+        bool tautology = false;
+        for (int j = begin; j < used; j++)
+        {
+            if (size > 0 && codes[begin + size - 1] == codes[j])
+            {
+                continue;
+            }
+            tautology |= size > 0 && (codes[begin + size - 1] ^ 1) == codes[j];
+            codes[begin + size++] = codes[j];
+        }
+        used = tautology ? begin : begin + size;
+        if (!tautology)
+        {
+            start[kept] = begin;
+            order[kept] = kept;
+            kept++;
+        }
+    }
+    start[kept] = used;
+
+    CanonicalKey key = {codes, start};
+    qsort_r(order, kept, sizeof(int), compare_canonical, &key);
+
+    uint64_t h[2] = {0xcbf29ce484222325ULL, 0x9e3779b97f4a7c15ULL};
+    hash_word(h, (uint32_t)formula->numVars);
+    int distinct = 0;
+    for (int i = 0; i < kept; i++)
+    {
+        if (i > 0 && compare_canonical(&order[i - 1], &order[i], &key) == 0)
+        {
+            continue;
+        }
+        distinct++;
+        for (int j = start[order[i]]; j < start[order[i] + 1]; j++)
+        {
+            hash_word(h, (uint32_t)codes[j]);
+        }
+        hash_word(h, 0); // Codes are at least 2, 0 ends the clause
+    }
+
+    snprintf(cache.key, sizeof(cache.key), "%016llx%016llx", (unsigned long long)hash_finish(h[0]),
+             (unsigned long long)hash_finish(h[1]));
+    cache.canonicalClauses = distinct;
+
+    free(order);
+    free(start);
+    free(codes);
+}
+
+char *cache_path(const char *suffix)
+{
+    size_t len = strlen(cache.dir) + strlen(cache.key) + strlen(suffix) + 8;
+    char *path = malloc(len);
+    snprintf(path, len, "%s/%s%s", cache.dir, cache.key, suffix);
+    return path;
+}
+
+// Entry for cache.key, in the DIMACS solution format with a header that repeats
+// the variable and canonical clause counts:
+//   c sat_solver cache <vars> <clauses>
+//   s SATISFIABLE | s UNSATISFIABLE
+//   v ... 0
+// A SAT entry is only used if its model satisfies the formula; an UNSAT entry
+// has to be trusted, so it also has to match both counts.
+bool cache_lookup(Formula *formula, int *assignments, DPLLReturnType *result)
+{
+    char *path = cache_path(".sol");
+    FILE *file = fopen(path, "r");
+    free(path);
+    cache.status = "miss";
+    if (!file)
+    {
+        return false;
+    }
+
+    int vars = -1, clauses = -1;
+    char status[32] = "";
+    bool valid = fscanf(file, "c sat_solver cache %d %d s %31s", &vars, &clauses, status) == 3 &&
+                 vars == formula->numVars && clauses == cache.canonicalClauses;
+    if (valid && strcmp(status, "UNSATISFIABLE") == 0)
+    {
+        *result = UNSAT;
+    }
+    else if (valid && strcmp(status, "SATISFIABLE") == 0)
+    {
+        *result = SAT;
+        for (int v = 1; v <= formula->numVars; v++)
+        {
+            assignments[v] = -1;
+        }
+        int lit;
+        char v_tag[2];
+        while (valid && fscanf(file, " %1[v]", v_tag) == 1)
+        {
+            while (fscanf(file, "%d", &lit) == 1 && lit != 0)
+            {
+                if (abs(lit) > formula->numVars)
+                {
+                    valid = false;
+                    break;
+                }
+                assignments[abs(lit)] = lit > 0;
+            }
+        }
+        valid = valid && verify_model(formula, assignments);
+    }
+    else
+    {
+        valid = false;
+    }
+    fclose(file);
+
+    cache.status = valid ? "hit" : "stale";
+    return valid;
+}
+
+// Written to a temporary file and renamed, so that concurrent jobs never read a
+// partial entry
+void cache_store(DPLLReturnType result, const int *assignments, int numVars)
+{
+    if (mkdir(cache.dir, 0777) != 0 && errno != EEXIST)
+    {
+        printf("Cannot create cache directory %s: %s\n", cache.dir, strerror(errno));
+        return;
+    }
+
+    char *path = cache_path(".sol");
+    char *tmp = cache_path(".tmp-XXXXXX");
+    int fd = mkstemp(tmp);
+    FILE *file = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!file)
+    {
+        printf("Cannot write cache entry %s\n", path);
+        free(tmp);
+        free(path);
+        return;
+    }
+
+    fprintf(file, "c sat_solver cache %d %d\n", numVars, cache.canonicalClauses);
+    fprintf(file, "s %s\n", result == SAT ? "SATISFIABLE" : "UNSATISFIABLE");
+    if (result == SAT)
+    {
+        write_model(file, assignments, numVars);
+    }
+    bool ok = fclose(file) == 0;
+    if (!ok || rename(tmp, path) != 0)
+    {
+        printf("Cannot write cache entry %s\n", path);
+        unlink(tmp);
+    }
+    free(tmp);
+    free(path);
+}
+
+// Checkpoint and resume
+
+// Options that change the decisions, a resumed search must use the same ones
+void checkpoint_config(char *buffer, size_t size)
+{
+    snprintf(buffer, size, "heuristic=%s symmetry=%d budget=%llu chain=%d generators=%d probe=%d probe_budget=%llu "
+             "bve=%d bve_budget=%llu bva=%d bva_budget=%llu simulate=%d simulate_budget=%llu simulate_seed=%llu "
+             "pure_literal=%d",
+             heuristic_names[heuristic], symmetry.enabled, symmetry.budget, symmetry.max_chain,
+             symmetry.max_generators, probing.enabled, probing.budget, elimination.enabled, elimination.budget, bva.enabled, bva.budget,
+             simulation.enabled, simulation.budget, (unsigned long long)simulation.seed, SAT_PURE_LITERAL);
+}
+
+// Current guiding path, the formula and configuration it belongs to and the
+// counters so far:
+//   c sat_solver checkpoint
+//   version 2
+//   formula <key> <vars> <clauses>     (hash as parsed, sizes after preprocessing)
+//   config <options>
+//   prior <decisions> <propagations> <conflicts> <seconds>
+//   path <depth> <literal>...
+// Written to a temporary file and renamed, so a preemption while writing keeps
+// the previous checkpoint.
+bool write_checkpoint()
+{
+    size_t len = strlen(checkpointing.path) + 8;
+    char *tmp = malloc(len);
+    snprintf(tmp, len, "%s.tmp", checkpointing.path);
+    FILE *file = fopen(tmp, "w");
+    if (!file)
+    {
+        printf("Cannot write checkpoint %s\n", tmp);
+        free(tmp);
+        return false;
+    }
+
+    char config[512];
+    checkpoint_config(config, sizeof(config));
+    fprintf(file, "c sat_solver checkpoint\nversion %d\nformula %s %d %d\nconfig %s\n", CHECKPOINT_VERSION, cache.key,
+            checkpointing.numVars, checkpointing.numClauses, config);
+    fprintf(file, "prior %llu %llu %llu %.3f\n", checkpointing.prior_decisions + stats.decisions,
+            checkpointing.prior_propagations + stats.propagations, checkpointing.prior_conflicts + stats.conflicts,
+            checkpointing.prior_seconds + wall_seconds() - start_wall);
+    fprintf(file, "path %d", search_depth);
+    for (int i = 0; i < search_depth; i++)
+    {
+        fprintf(file, " %d", decision_path[i]);
+    }
+    fprintf(file, "\n");
+
+    bool ok = fclose(file) == 0 && rename(tmp, checkpointing.path) == 0;
+    if (!ok)
+    {
+        printf("Cannot write checkpoint %s\n", checkpointing.path);
+        unlink(tmp);
+    }
+    checkpointing.written += ok;
+    free(tmp);
+    return ok;
+}
+
+// Checkpoint for the preprocessed formula, rejected unless the formula hash,
+// sizes and configuration all match. Prepares the path for replay.
+bool load_checkpoint(const char *path, Formula *formula)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        printf("Cannot read checkpoint %s\n", path);
+        return false;
+    }
+
+    int version = 0, vars = -1, clauses = -1, depth = -1;
+    char key[sizeof(cache.key)] = "", config[512] = "", expected[512];
+    checkpoint_config(expected, sizeof(expected));
+    bool valid = fscanf(file, "c sat_solver checkpoint version %d formula %32s %d %d config %511[^\n]", &version, key,
+                        &vars, &clauses, config) == 5 &&
+                 fscanf(file, " prior %llu %llu %llu %lf path %d", &checkpointing.prior_decisions,
+                        &checkpointing.prior_propagations, &checkpointing.prior_conflicts,
+                        &checkpointing.prior_seconds, &depth) == 5;
+    if (!valid || version != CHECKPOINT_VERSION)
+    {
+        printf("Checkpoint %s is damaged or from another version\n", path);
+    }
+    else if (strcmp(key, cache.key) != 0 || vars != formula->numVars || clauses != formula->numClauses)
+    {
+        printf("Checkpoint %s belongs to another formula\n", path);
+        valid = false;
+    }
+    else if (strcmp(config, expected) != 0)
+    {
+        printf("Checkpoint %s was written with other options (%s)\n", path, config);
+        valid = false;
+    }
+
+    valid = valid && depth >= 0 && depth <= formula->numVars;
+    checkpointing.resume_path = malloc(sizeof(int) * (depth > 0 ? depth : 1));
+    for (int i = 0; valid && i < depth; i++)
+    {
+        valid = fscanf(file, "%d", &checkpointing.resume_path[i]) == 1 && checkpointing.resume_path[i] != 0 &&
+                abs(checkpointing.resume_path[i]) <= formula->numVars;
+    }
+    fclose(file);
+
+    if (!valid)
+    {
+        free(checkpointing.resume_path);
+        checkpointing.resume_path = NULL;
+        return false;
+    }
+    checkpointing.resume_depth = depth;
+    checkpointing.replaying = depth > 0;
+    return true;
+}
+
+// The path of an interrupted search as the one to replay next, without a file
+void checkpoint_capture()
+{
+    free(checkpointing.resume_path);
+    checkpointing.resume_path = malloc(sizeof(int) * (search_depth > 0 ? search_depth : 1));
+    memcpy(checkpointing.resume_path, decision_path, sizeof(int) * search_depth);
+    checkpointing.resume_depth = search_depth;
+    checkpointing.replaying = search_depth > 0;
+}
+
+// Occurrence lists
+
+static inline int code_to_int(int code)
+{
+    return (code & 1) ? -(code >> 1) : (code >> 1);
+}
+
+// Room for the literal codes of numVars variables and numClauses clauses
+void occ_reserve(OccurrenceLists *state, int numVars, int numClauses)
+{
+    int codes = 2 * numVars + 2;
+    if (codes > state->numCodes)
+    {
+        state->occurs = realloc(state->occurs, sizeof(GArray *) * codes);
+        state->count = realloc(state->count, sizeof(int) * codes);
+        state->stamp = realloc(state->stamp, sizeof(int) * codes);
+        state->tally = realloc(state->tally, sizeof(int) * codes);
+        state->paired = realloc(state->paired, sizeof(int) * codes);
+        for (int c = state->numCodes; c < codes; c++)
+        {
+            state->occurs[c] = g_array_new(FALSE, FALSE, sizeof(int));
+            state->count[c] = 0;
+            state->stamp[c] = 0;
+            state->tally[c] = 0;
+            state->paired[c] = -1;
+        }
+        state->numCodes = codes;
+    }
+    if (numClauses > state->removedCapacity)
+    {
+        int capacity = numClauses * 2 + 16;
+        state->removed = realloc(state->removed, sizeof(bool) * capacity);
+        memset(state->removed + state->removedCapacity, 0, sizeof(bool) * (capacity - state->removedCapacity));
+        state->claimed = realloc(state->claimed, sizeof(int) * capacity);
+        memset(state->claimed + state->removedCapacity, 0, sizeof(int) * (capacity - state->removedCapacity));
+        state->removedCapacity = capacity;
+    }
+}
+
+void occ_add_clause(OccurrenceLists *state, int index)
+{
+    Clause *clause = &state->formula->clauses[index];
+    for (int i = 0; i < clause->size; i++)
+    {
+        int code = literal_code(clause->literals[i]);
+        g_array_append_val(state->occurs[code], index);
+        state->count[code]++;
+    }
+}
+
+void occ_remove_clause(OccurrenceLists *state, int index)
+{
+    Clause *clause = &state->formula->clauses[index];
+    state->removed[index] = true;
+    for (int i = 0; i < clause->size; i++)
+    {
+        state->count[literal_code(clause->literals[i])]--;
+    }
+}
+
+// Occurrences of code without the removed clauses, which are dropped here
+GArray *occ_live(OccurrenceLists *state, int code)
+{
+    GArray *list = state->occurs[code];
+    int *items = (int *)list->data;
+    guint kept = 0;
+    for (guint i = 0; i < list->len; i++)
+    {
+        if (!state->removed[items[i]])
+            items[kept++] = items[i];
+    }
+    g_array_set_size(list, kept);
+    return list;
+}
+
+// Stamp the literals of clause index, so that membership is one comparison
+void occ_mark(OccurrenceLists *state, int index)
+{
+    Clause *clause = &state->formula->clauses[index];
+    state->epoch++;
+    for (int i = 0; i < clause->size; i++)
+    {
+        state->stamp[literal_code(clause->literals[i])] = state->epoch;
+    }
+}
+
+// Occurrence lists of every clause of the formula
+OccurrenceLists occ_init(Formula *formula)
+{
+    OccurrenceLists state = {formula, formula->numClauses, 0, NULL, NULL, NULL, NULL, NULL, 0, NULL, NULL, 0, NULL};
+    occ_reserve(&state, formula->numVars, formula->numClauses);
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        occ_add_clause(&state, i);
+    }
+    return state;
+}
+
+// Drop the removed clauses from the formula and free the lists
+void occ_finish(OccurrenceLists *state)
+{
+    Formula *formula = state->formula;
+    int kept = 0;
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (state->removed[i])
+            free(formula->clauses[i].literals);
+        else
+            formula->clauses[kept++] = formula->clauses[i];
+    }
+    formula->numClauses = kept;
+
+    for (int code = 0; code < state->numCodes; code++)
+    {
+        g_array_free(state->occurs[code], TRUE);
+    }
+    free(state->occurs);
+    free(state->count);
+    free(state->stamp);
+    free(state->tally);
+    free(state->paired);
+    free(state->removed);
+    free(state->claimed);
+}
+
+// Bounded variable addition
+
+void bva_queue_push(OccurrenceLists *state, int code)
+{
+    if (state->count[code] < 2)
+        return;
+
+    guint64 entry = ((guint64)state->count[code] << 32) | (guint32)code;
+    g_array_append_val(state->queue, entry);
+    guint64 *heap = (guint64 *)state->queue->data;
+    for (guint i = state->queue->len - 1; i > 0 && heap[(i - 1) / 2] < heap[i]; i = (i - 1) / 2)
+    {
+        guint64 tmp = heap[i];
+        heap[i] = heap[(i - 1) / 2];
+        heap[(i - 1) / 2] = tmp;
+    }
+}
+
+// Literal with the most occurrences, -1 when the queue is empty. Entries whose
+// count changed since they were pushed are pushed again with the current one.
+int bva_queue_pop(OccurrenceLists *state)
+{
+    while (state->queue->len > 0)
+    {
+        guint64 *heap = (guint64 *)state->queue->data;
+        guint64 top = heap[0];
+        guint last = state->queue->len - 1;
+        heap[0] = heap[last];
+        g_array_set_size(state->queue, last);
+        for (guint i = 0;;)
+        {
+            guint child = 2 * i + 1;
+            if (child >= last)
+                break;
+            if (child + 1 < last && heap[child + 1] > heap[child])
+                child++;
+            if (heap[i] >= heap[child])
+                break;
+            guint64 tmp = heap[i];
+            heap[i] = heap[child];
+            heap[child] = tmp;
+            i = child;
+        }
+
+        int code = (int)(top & 0xffffffffu);
+        if ((int)(top >> 32) == state->count[code])
+            return code;
+        bva_queue_push(state, code);
+    }
+    return -1;
+}
+
+// Literal of the rest of clause index (without code lit) with the fewest
+// occurrences, -1 for a unit clause
+int bva_least_occurring(OccurrenceLists *state, int index, int lit)
+{
+    Clause *clause = &state->formula->clauses[index];
+    int best = -1;
+    for (int i = 0; i < clause->size; i++)
+    {
+        int code = literal_code(clause->literals[i]);
+        if (code != lit && (best < 0 || state->count[code] < state->count[best]))
+            best = code;
+    }
+    return best;
+}
+
+// With the marked clause C containing lit, the literal other than lit of a
+// clause D = C - lit + other of the same size, or -1 if D is not of that form
+int bva_match(OccurrenceLists *state, int candidate, int index, int lit)
+{
+    Clause *clause = &state->formula->clauses[candidate];
+    if (candidate == index || state->removed[candidate] || clause->size != state->formula->clauses[index].size)
+        return -1;
+
+    bva.steps += clause->size;
+    int other = -1;
+    for (int i = 0; i < clause->size; i++)
+    {
+        int code = literal_code(clause->literals[i]);
+        if (code == lit)
+            return -1;
+        if (state->stamp[code] != state->epoch)
+        {
+            if (other >= 0)
+                return -1;
+            other = code;
+        }
+    }
+    return other;
+}
+
+static inline int bva_reduction(int numLits, int numClauses)
+{
+    return numLits * numClauses - numLits - numClauses;
+}
+
+// Grow the literal set of lit greedily (SimpleBVA): in each round, the literal
+// that completes the most clauses of the current set is added while the clause
+// reduction still grows. Applies the best set found; returns false if none.
+bool bva_literal(OccurrenceLists *state, int lit)
+{
+    GArray *mlits = g_array_new(FALSE, FALSE, sizeof(int));
+    GArray *mclauses = g_array_new(FALSE, FALSE, sizeof(int));
+    GArray *pairs = g_array_new(FALSE, FALSE, sizeof(int)); // (other, clause) pairs
+    g_array_append_val(mlits, lit);
+    GArray *list = occ_live(state, lit);
+    for (guint i = 0; i < list->len; i++)
+    {
+        int index = g_array_index(list, int, i);
+        if (state->formula->clauses[index].size > 1)
+            g_array_append_val(mclauses, index);
+    }
+
+    while (bva.steps < bva.budget)
+    {
+        int round = ++state->epoch;
+        g_array_set_size(pairs, 0);
+        for (guint k = 0; k < mlits->len; k++)
+        {
+            state->tally[g_array_index(mlits, int, k)] = -1;
+        }
+        for (guint i = 0; i < mclauses->len; i++)
+        {
+            int index = g_array_index(mclauses, int, i);
+            occ_mark(state, index);
+            GArray *candidates = occ_live(state, bva_least_occurring(state, index, lit));
+            for (guint j = 0; j < candidates->len; j++)
+            {
+                // Each pair and each matched clause are counted once, so that
+                // duplicate clauses do not inflate the grid
+                int candidate = g_array_index(candidates, int, j);
+                if (state->claimed[candidate] == round)
+                    continue;
+                int other = bva_match(state, candidate, index, lit);
+                if (other >= 0 && other != (lit ^ 1) && state->tally[other] >= 0 && state->paired[other] != index)
+                {
+                    state->paired[other] = index;
+                    state->claimed[candidate] = round;
+                    g_array_append_val(pairs, other);
+                    g_array_append_val(pairs, index);
+                }
+            }
+        }
+
+        // Literals of the set are tallied -1 while matching, they already match every clause
+        int best = -1;
+        for (guint i = 0; i < pairs->len; i += 2)
+        {
+            int other = g_array_index(pairs, int, i);
+            if (++state->tally[other] > (best < 0 ? 0 : state->tally[best]))
+                best = other;
+        }
+        for (guint i = 0; i < pairs->len; i += 2)
+        {
+            state->tally[g_array_index(pairs, int, i)] = 0;
+            state->paired[g_array_index(pairs, int, i)] = -1;
+        }
+        for (guint k = 0; k < mlits->len; k++)
+        {
+            state->tally[g_array_index(mlits, int, k)] = 0;
+        }
+        if (best < 0)
+            break;
+
+        int matched = 0;
+        for (guint i = 0; i < pairs->len; i += 2)
+        {
+            matched += g_array_index(pairs, int, i) == best;
+        }
+        if (bva_reduction(mlits->len + 1, matched) <= bva_reduction(mlits->len, mclauses->len))
+            break;
+
+        g_array_set_size(mclauses, 0);
+        for (guint i = 0; i < pairs->len; i += 2)
+        {
+            if (g_array_index(pairs, int, i) == best)
+                g_array_append_val(mclauses, g_array_index(pairs, int, i + 1));
+        }
+        g_array_append_val(mlits, best);
+    }
+    if (bva.steps >= bva.budget)
+    {
+        bva.exhausted = true;
+    }
+
+    bool applied = mlits->len > 1 && bva_reduction(mlits->len, mclauses->len) > 0;
+    if (applied)
+    {
+        Formula *formula = state->formula;
+        int x = ++formula->numVars;
+        occ_reserve(state, formula->numVars, formula->numClauses + mlits->len + mclauses->len);
+
+        // Every clause C - lit + other of the grid exists, it matched above
+        int removed = 0;
+        for (guint i = 0; i < mclauses->len; i++)
+        {
+            int index = g_array_index(mclauses, int, i);
+            occ_mark(state, index);
+            occ_remove_clause(state, index);
+            removed++;
+            for (guint k = 1; k < mlits->len; k++)
+            {
+                int other = g_array_index(mlits, int, k);
+                GArray *candidates = occ_live(state, other);
+                for (guint j = 0; j < candidates->len; j++)
                 {
-                    Literal *lit_copy = malloc(sizeof(Literal));
-                    lit_copy->var = oplit.var;
-                    lit_copy->neg = oplit.neg;
-                    g_queue_push_tail(queue, lit_copy);
-                    continue;
+                    int candidate = g_array_index(candidates, int, j);
+                    if (bva_match(state, candidate, index, lit) == other)
+                    {
+                        occ_remove_clause(state, candidate);
+                        removed++;
+                        break;
+                    }
                 }
             }
+        }
 
-            // If the other watched literal is already satisfied, skip the clause.
-            int other_a = assignments[other.var];
-            if ((other_a == 1 && !other.neg) || (other_a == 0 && other.neg))
+        int pair[2] = {0, x};
+        for (guint k = 0; k < mlits->len; k++)
+        {
+            pair[0] = code_to_int(g_array_index(mlits, int, k));
+            add_clause(formula, &state->capacity, pair, 2);
+            occ_add_clause(state, formula->numClauses - 1);
+        }
+        int longest = 0;
+        for (guint i = 0; i < mclauses->len; i++)
+        {
+            int size = formula->clauses[g_array_index(mclauses, int, i)].size;
+            longest = size > longest ? size : longest;
+        }
+        int *lits = malloc(sizeof(int) * longest);
+        for (guint i = 0; i < mclauses->len; i++)
+        {
+            Clause *clause = &formula->clauses[g_array_index(mclauses, int, i)];
+            int size = 0;
+            for (int j = 0; j < clause->size; j++)
+            {
+                int code = literal_code(clause->literals[j]);
+                lits[size++] = code == lit ? -x : code_to_int(code);
+            }
+            add_clause(formula, &state->capacity, lits, size);
+            occ_add_clause(state, formula->numClauses - 1);
+        }
+        free(lits);
+
+        int added = mlits->len + mclauses->len;
+        bva.vars_added++;
+        bva.clauses_removed += removed;
+        bva.clauses_added += added;
+        bva.least_gain = removed - added < bva.least_gain ? removed - added : bva.least_gain;
+        bva_queue_push(state, lit);
+        bva_queue_push(state, 2 * x + 1);
+    }
+
+    g_array_free(mlits, TRUE);
+    g_array_free(mclauses, TRUE);
+    g_array_free(pairs, TRUE);
+    return applied;
+}
+
+// Run BVA on the formula until no literal gives a reduction or the budget runs
+// out. Fresh variables are numbered after the original ones; the formula keeps
+// the models of the original one once they are projected to its variables.
+void bounded_variable_addition(Formula *formula)
+{
+    OccurrenceLists state = occ_init(formula);
+    state.queue = g_array_new(FALSE, FALSE, sizeof(guint64));
+    for (int code = 2; code < state.numCodes; code++)
+    {
+        bva_queue_push(&state, code);
+    }
+
+    int lit;
+    while (bva.steps < bva.budget && (lit = bva_queue_pop(&state)) >= 0)
+    {
+        bva_literal(&state, lit);
+    }
+    if (bva.steps >= bva.budget)
+    {
+        bva.exhausted = true;
+    }
+
+    g_array_free(state.queue, TRUE);
+    occ_finish(&state);
+}
+
+// Variable elimination
+
+// Live clause with exactly the given literal codes, -1 if there is none
+int occ_find(OccurrenceLists *state, const int *codes, int size)
+{
+    state->epoch++;
+    for (int i = 0; i < size; i++)
+    {
+        state->stamp[codes[i]] = state->epoch;
+    }
+
+    GArray *list = occ_live(state, codes[0]);
+    for (guint i = 0; i < list->len; i++)
+    {
+        int index = g_array_index(list, int, i);
+        Clause *clause = &state->formula->clauses[index];
+        if (clause->size != size)
+            continue;
+
+        elimination.steps += size;
+        bool all = true;
+        for (int j = 0; j < size && all; j++)
+        {
+            all = state->stamp[literal_code(clause->literals[j])] == state->epoch;
+        }
+        if (all)
+            return index;
+    }
+    return -1;
+}
+
+// The two literals of a ternary clause other than code, false if it has fewer
+bool other_two(const Clause *clause, int code, int *a, int *b)
+{
+    int found = 0;
+    for (int i = 0; i < clause->size; i++)
+    {
+        int other = literal_code(clause->literals[i]);
+        if (other == code)
+            continue;
+        if (found == 0)
+            *a = other;
+        else
+            *b = other;
+        found++;
+    }
+    return clause->size == 3 && found == 2;
+}
+
+void set_gate(Gate *gate, GateType type, int out, const int *inputs, int numInputs)
+{
+    gate->type = type;
+    gate->output = code_to_int(out);
+    gate->numInputs = numInputs;
+    gate->inputs = malloc(sizeof(int) * numInputs);
+    for (int i = 0; i < numInputs; i++)
+    {
+        gate->inputs[i] = code_to_int(inputs[i]);
+    }
+    gate->eliminated = false;
+}
+
+// out = AND(a_1..a_k): binary clauses (-out | a_i) and the clause
+// (out | -a_1 | .. | -a_k). With a negated output this is also an OR gate.
+bool find_and_gate(OccurrenceLists *state, int out, GArray *gateClauses, Gate *gate)
+{
+    GArray *binaries = occ_live(state, out ^ 1);
+    state->epoch++;
+    for (guint i = 0; i < binaries->len; i++)
+    {
+        int index = g_array_index(binaries, int, i);
+        Clause *clause = &state->formula->clauses[index];
+        if (clause->size != 2)
+            continue;
+
+        int a = literal_code(clause->literals[0]) == (out ^ 1) ? literal_code(clause->literals[1])
+                                                                : literal_code(clause->literals[0]);
+        state->stamp[a] = state->epoch;
+        state->tally[a] = index;
+    }
+
+    GArray *candidates = occ_live(state, out);
+    for (guint i = 0; i < candidates->len; i++)
+    {
+        int index = g_array_index(candidates, int, i);
+        Clause *clause = &state->formula->clauses[index];
+        if (clause->size < 2)
+            continue;
+
+        elimination.steps += clause->size;
+        bool all = true;
+        for (int j = 0; j < clause->size && all; j++)
+        {
+            int code = literal_code(clause->literals[j]);
+            all = code == out || state->stamp[code ^ 1] == state->epoch;
+        }
+        if (!all)
+            continue;
+
+        int *inputs = malloc(sizeof(int) * (clause->size - 1));
+        int numInputs = 0;
+        g_array_append_val(gateClauses, index);
+        for (int j = 0; j < clause->size; j++)
+        {
+            int code = literal_code(clause->literals[j]);
+            if (code != out)
             {
+                inputs[numInputs++] = code ^ 1;
+                g_array_append_val(gateClauses, state->tally[code ^ 1]);
+            }
+        }
+        set_gate(gate, GATE_AND, out, inputs, numInputs);
+        free(inputs);
+        return true;
+    }
+    return false;
+}
+
+// Four ternary clauses over var, a and b, each forbidding one assignment of the
+// same parity: (c0 | c1 | c2) and the three with two literals negated. Then
+// c0 = -c1 XOR c2.
+bool find_xor_gate(OccurrenceLists *state, int var, GArray *gateClauses, Gate *gate)
+{
+    for (int c0 = 2 * var; c0 <= 2 * var + 1; c0++)
+    {
+        GArray *list = occ_live(state, c0);
+        for (guint i = 0; i < list->len; i++)
+        {
+            int index = g_array_index(list, int, i), c1 = 0, c2 = 0;
+            if (!other_two(&state->formula->clauses[index], c0, &c1, &c2) || (c1 >> 1) == (c2 >> 1))
                 continue;
+
+            // occ_find scans the list of the first literal, never the one iterated here
+            int flipped[3][3] = {{c0 ^ 1, c1 ^ 1, c2}, {c0 ^ 1, c1, c2 ^ 1}, {c1 ^ 1, c2 ^ 1, c0}};
+            int found[3];
+            bool all = true;
+            for (int k = 0; k < 3 && all; k++)
+            {
+                found[k] = occ_find(state, flipped[k], 3);
+                all = found[k] >= 0;
             }
+            if (!all)
+                continue;
 
-            // Now we try to replace the watched literal with a new literal.
-            bool found = false;
-            for (int j = 0; j < clause->size; j++)
+            g_array_append_val(gateClauses, index);
+            g_array_append_vals(gateClauses, found, 3);
+            int inputs[2] = {c1 ^ 1, c2};
+            set_gate(gate, GATE_XOR, c0, inputs, 2);
+            return true;
+        }
+    }
+    return false;
+}
+
+// out = ITE(c, t, e): (-out | -c | t), (-out | c | e), (out | -c | -t) and
+// (out | c | -e)
+bool find_ite_gate(OccurrenceLists *state, int var, GArray *gateClauses, Gate *gate)
+{
+    for (int out = 2 * var; out <= 2 * var + 1; out++)
+    {
+        GArray *list = occ_live(state, out ^ 1);
+        for (guint i = 0; i < list->len; i++)
+        {
+            int first = g_array_index(list, int, i), x = 0, y = 0;
+            if (!other_two(&state->formula->clauses[first], out ^ 1, &x, &y))
+                continue;
+
+            for (int order = 0; order < 2; order++)
             {
-                Literal nlit = clause->literals[j];
-                int indexn = watchlist_index(nlit, formula->numVars);
+                int notc = order ? y : x, t = order ? x : y;
+                int third[3] = {out, notc, t ^ 1};
+                int thirdIndex = occ_find(state, third, 3);
+                if (thirdIndex < 0)
+                    continue;
 
-                // If it matches one of the literals the clause is already looking at, skip it.
-                if (indexn == index || (nlit.var == other.var && nlit.neg == other.neg))
+                int c = notc ^ 1;
+                for (guint j = 0; j < list->len; j++)
                 {
-                    continue;
+                    int second = g_array_index(list, int, j), u = 0, w = 0;
+                    if (!other_two(&state->formula->clauses[second], out ^ 1, &u, &w) || (u != c && w != c))
+                        continue;
+
+                    int e = u == c ? w : u;
+                    int fourth[3] = {out, c, e ^ 1};
+                    int fourthIndex = occ_find(state, fourth, 3);
+                    if (fourthIndex < 0)
+                        continue;
+
+                    int clauses[4] = {first, second, thirdIndex, fourthIndex};
+                    g_array_append_vals(gateClauses, clauses, 4);
+                    int inputs[3] = {c, t, e};
+                    set_gate(gate, GATE_ITE, out, inputs, 3);
+                    return true;
                 }
+            }
+        }
+    }
+    return false;
+}
 
-                // If the next literal is unassigned, or satisfies the clause, then we watch it.
-                int assign_nlit = assignments[nlit.var];
-                if (assign_nlit == -1 || (assign_nlit == 0 && nlit.neg) || (assign_nlit == 1 && !nlit.neg))
+// Gate with output var, its clauses in gateClauses
+bool find_gate(OccurrenceLists *state, int var, GArray *gateClauses, Gate *gate)
+{
+    g_array_set_size(gateClauses, 0);
+    return find_and_gate(state, 2 * var, gateClauses, gate) || find_and_gate(state, 2 * var + 1, gateClauses, gate) ||
+           find_xor_gate(state, var, gateClauses, gate) || find_ite_gate(state, var, gateClauses, gate);
+}
+
+bool in_gate(GArray *gateClauses, int index)
+{
+    for (guint i = 0; i < gateClauses->len; i++)
+    {
+        if (g_array_index(gateClauses, int, i) == index)
+            return true;
+    }
+    return false;
+}
+
+// Resolvent of clauses a (with var) and b (with -var) into resolvent as literal
+// codes; false for a tautology
+bool resolve(OccurrenceLists *state, int a, int b, int var, GArray *resolvent)
+{
+    Clause *pos = &state->formula->clauses[a];
+    Clause *neg = &state->formula->clauses[b];
+    elimination.steps += pos->size + neg->size;
+    g_array_set_size(resolvent, 0);
+    state->epoch++;
+    for (int i = 0; i < pos->size; i++)
+    {
+        int code = literal_code(pos->literals[i]);
+        if ((code >> 1) != var)
+        {
+            state->stamp[code] = state->epoch;
+            g_array_append_val(resolvent, code);
+        }
+    }
+    for (int i = 0; i < neg->size; i++)
+    {
+        int code = literal_code(neg->literals[i]);
+        if ((code >> 1) == var || state->stamp[code] == state->epoch)
+            continue;
+        if (state->stamp[code ^ 1] == state->epoch)
+            return false;
+        g_array_append_val(resolvent, code);
+    }
+    return true;
+}
+
+// Replace var by its resolvents if there are at most as many as its clauses, none
+// empty or longer than max_resolvent. Resolvents already in the formula are not
+// added and do not count. The gate definition used is added to elimination.gates.
+bool eliminate_variable(OccurrenceLists *state, int var, GArray *gateClauses, GArray *resolvent)
+{
+    GArray *posList = occ_live(state, 2 * var);
+    GArray *negList = occ_live(state, 2 * var + 1);
+    int numPos = posList->len, numNeg = negList->len;
+    if (numPos + numNeg == 0 || numPos + numNeg > elimination.max_occurrences)
+        return false;
+
+    int *pos = malloc(sizeof(int) * (numPos + numNeg + 1));
+    int *neg = pos + numPos;
+    memcpy(pos, posList->data, sizeof(int) * numPos);
+    memcpy(neg, negList->data, sizeof(int) * numNeg);
+
+    Gate gate;
+    bool defined = find_gate(state, var, gateClauses, &gate);
+    int count = 0;
+    bool bounded = true;
+    for (int i = 0; i < numPos && bounded; i++)
+    {
+        for (int j = 0; j < numNeg && bounded; j++)
+        {
+            if (defined && in_gate(gateClauses, pos[i]) == in_gate(gateClauses, neg[j]))
+                continue;
+            if (!resolve(state, pos[i], neg[j], var, resolvent))
+                continue;
+            bounded = resolvent->len > 0 && (int)resolvent->len <= elimination.max_resolvent;
+            if (bounded && occ_find(state, (int *)resolvent->data, resolvent->len) < 0)
+                bounded = ++count <= numPos + numNeg;
+        }
+    }
+
+    if (bounded)
+    {
+        Formula *formula = state->formula;
+        int added = 0;
+        occ_reserve(state, formula->numVars, formula->numClauses + count);
+        for (int i = 0; i < numPos; i++)
+        {
+            for (int j = 0; j < numNeg; j++)
+            {
+                if (defined && in_gate(gateClauses, pos[i]) == in_gate(gateClauses, neg[j]))
+                    continue;
+                if (!resolve(state, pos[i], neg[j], var, resolvent) ||
+                    occ_find(state, (int *)resolvent->data, resolvent->len) >= 0)
+                    continue;
+                int *lits = (int *)resolvent->data;
+                for (guint k = 0; k < resolvent->len; k++)
                 {
-                    watchtable_remove(wtable, index, indexi, stack);
-                    watchtable_add(wtable, indexn, indexi, stack);
-                    found = true;
-                    break;
+                    lits[k] = code_to_int(lits[k]);
                 }
+                add_clause(formula, &state->capacity, lits, resolvent->len);
+                occ_add_clause(state, formula->numClauses - 1);
+                proof_add_clause(lits, resolvent->len);
+                added++;
             }
+        }
 
-            // If we could find no new literals to watch because of a unit clause or conflicts
-            if (!found)
+        // Witness literal first, the size last, so the stack can be read backwards
+        for (int i = 0; i < numPos + numNeg; i++)
+        {
+            Clause *clause = &formula->clauses[pos[i]];
+            int witness = i < numPos ? var : -var;
+            g_array_append_val(elimination.stack, witness);
+            for (int j = 0; j < clause->size; j++)
+            {
+                int lit = clause->literals[j].neg ? -clause->literals[j].var : clause->literals[j].var;
+                if (lit != witness)
+                    g_array_append_val(elimination.stack, lit);
+            }
+            g_array_append_val(elimination.stack, clause->size);
+            proof_delete_clause(clause);
+            occ_remove_clause(state, pos[i]);
+        }
+
+        elimination.eliminated++;
+        elimination.clauses_removed += numPos + numNeg;
+        elimination.clauses_added += added;
+    }
+
+    if (defined && bounded)
+    {
+        gate.eliminated = true;
+        elimination.definitions[gate.type]++;
+        g_array_append_val(elimination.gates, gate);
+    }
+    else if (defined)
+    {
+        free(gate.inputs);
+    }
+    free(pos);
+    return bounded;
+}
+
+int compare_elimination_cost(const void *a, const void *b, void *count)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    const int *c = count;
+    long costX = (long)c[2 * x] * c[2 * x + 1], costY = (long)c[2 * y] * c[2 * y + 1];
+    return costX != costY ? (costX > costY) - (costX < costY) : x - y;
+}
+
+// Eliminate variables, cheapest (fewest positive times negative occurrences)
+// first, in rounds until a round eliminates nothing or the budget runs out.
+// Tautologies are dropped first, a gate's clauses must not contain its output
+// twice. Eliminated variables keep their numbers and stay unassigned in the
+// search; reconstruct_model gives them values.
+void eliminate_variables(Formula *formula)
+{
+    OccurrenceLists state = occ_init(formula);
+    elimination.gates = g_array_new(FALSE, FALSE, sizeof(Gate));
+    elimination.stack = g_array_new(FALSE, FALSE, sizeof(int));
+    GArray *gateClauses = g_array_new(FALSE, FALSE, sizeof(int));
+    GArray *resolvent = g_array_new(FALSE, FALSE, sizeof(int));
+
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        occ_mark(&state, i);
+        for (int j = 0; j < formula->clauses[i].size; j++)
+        {
+            if (state.stamp[literal_code(formula->clauses[i].literals[j]) ^ 1] == state.epoch)
+            {
+                proof_delete_clause(&formula->clauses[i]);
+                occ_remove_clause(&state, i);
+                break;
+            }
+        }
+    }
+
+    int *order = malloc(sizeof(int) * (formula->numVars + 1));
+    bool *done = calloc(formula->numVars + 1, sizeof(bool));
+    bool progress = true;
+    while (progress && elimination.steps < elimination.budget)
+    {
+        progress = false;
+        int numCandidates = 0;
+        for (int var = 1; var <= formula->numVars; var++)
+        {
+            if (!done[var] && state.count[2 * var] + state.count[2 * var + 1] > 0)
+                order[numCandidates++] = var;
+        }
+        qsort_r(order, numCandidates, sizeof(int), compare_elimination_cost, state.count);
+
+        for (int i = 0; i < numCandidates && elimination.steps < elimination.budget; i++)
+        {
+            if (eliminate_variable(&state, order[i], gateClauses, resolvent))
+            {
+                done[order[i]] = true;
+                progress = true;
+            }
+        }
+    }
+    elimination.exhausted = elimination.steps >= elimination.budget;
+
+    // Definitions of the variables that stay, for the decision order
+    for (int var = 1; var <= formula->numVars; var++)
+    {
+        Gate gate;
+        if (!done[var] && state.count[2 * var] + state.count[2 * var + 1] > 0 &&
+            find_gate(&state, var, gateClauses, &gate))
+        {
+            g_array_append_val(elimination.gates, gate);
+        }
+    }
+
+    free(order);
+    free(done);
+    g_array_free(gateClauses, TRUE);
+    g_array_free(resolvent, TRUE);
+    occ_finish(&state);
+}
+
+// Give the eliminated variables values, last eliminated first: a clause of the
+// stack that is not satisfied gets its witness literal set. At most one polarity
+// of a variable can be forced, its resolvents are in the formula. A variable that
+// nothing forces stays unassigned, which counts as false like everywhere else.
+void reconstruct_model(int *assignments)
+{
+    if (!elimination.stack)
+        return;
+
+    const int *stack = (const int *)elimination.stack->data;
+    for (int end = elimination.stack->len; end > 0;)
+    {
+        int size = stack[end - 1];
+        const int *clause = &stack[end - 1 - size];
+        end -= size + 1;
+
+        bool satisfied = false;
+        for (int i = 1; i < size && !satisfied; i++)
+        {
+            satisfied = (assignments[abs(clause[i])] == 1) == (clause[i] > 0);
+        }
+        if (!satisfied)
+        {
+            assignments[abs(clause[0])] = clause[0] > 0;
+        }
+    }
+}
+
+void free_elimination()
+{
+    if (elimination.gates)
+    {
+        for (guint g = 0; g < elimination.gates->len; g++)
+        {
+            free(g_array_index(elimination.gates, Gate, g).inputs);
+        }
+        g_array_free(elimination.gates, TRUE);
+        elimination.gates = NULL;
+    }
+    if (elimination.stack)
+    {
+        g_array_free(elimination.stack, TRUE);
+        elimination.stack = NULL;
+    }
+}
+
+// Variables whose value follows from others are decided last: those added by
+// BVA and the outputs of the gates recognized by elimination
+void defer_defined_variables(int *order, int numVars, int numVarsOriginal)
+{
+    if (!bva.enabled && !elimination.enabled)
+        return;
+
+    bool *deferred = calloc(numVars + 1, sizeof(bool));
+    for (int var = numVarsOriginal + 1; var <= numVars; var++)
+    {
+        deferred[var] = true;
+    }
+    for (guint g = 0; elimination.gates && g < elimination.gates->len; g++)
+    {
+        Gate *gate = &g_array_index(elimination.gates, Gate, g);
+        deferred[abs(gate->output)] |= !gate->eliminated;
+    }
+    defer_variables(order, deferred);
+    free(deferred);
+}
+
+// Failed-literal probing
+
+// Assignments of a probing pass, level 0 first on the trail. The literals of a
+// probe form a tree rooted at the probe whose edges are binary clauses, original
+// ones or hyper-binary resolvents.
+typedef struct
+{
+    OccurrenceLists occ;
+    int *value;  // Per variable: -1 unassigned, 0 false, 1 true
+    int *parent; // Per variable: code of the literal implying it by a binary clause, -1 for the probe
+    int *depth;  // Per variable: edges from the probe, -1 at level 0
+    int *trail;  // Literal codes in assignment order
+    int trailSize;
+    int fixed;    // Trail size of level 0
+    int level;    // 1 while a probe is assigned
+    int *reached; // Per literal code: last round in which a probe implied it
+} ProbeState;
+
+void probe_assign(ProbeState *state, int code, int parent)
+{
+    int var = code >> 1;
+    state->value[var] = !(code & 1);
+    state->parent[var] = parent;
+    state->depth[var] = state->level == 0 ? -1 : parent < 0 ? 0 : state->depth[parent >> 1] + 1;
+    state->trail[state->trailSize++] = code;
+}
+
+// Closest common ancestor in the probe tree of the true negations of the false
+// literals of clause; literals fixed at level 0 are left out
+int probe_dominator(const ProbeState *state, const Clause *clause, int unit)
+{
+    int dominator = -1;
+    for (int i = 0; i < clause->size; i++)
+    {
+        int code = literal_code(clause->literals[i]) ^ 1;
+        if (code >> 1 == unit >> 1 || state->depth[code >> 1] < 0)
+            continue;
+        if (dominator < 0)
+        {
+            dominator = code;
+            continue;
+        }
+        while (dominator != code)
+        {
+            if (state->depth[dominator >> 1] >= state->depth[code >> 1])
+                dominator = state->parent[dominator >> 1];
+            else
+                code = state->parent[code >> 1];
+        }
+    }
+    return dominator;
+}
+
+// Propagate the trail from head over the live clauses, false on a conflict.
+// Binary clauses go first, so a longer clause only becomes unit for a literal
+// that the binary implications of the trail do not reach. Under a probe, it
+// then adds the hyper-binary resolvent of its dominator and that literal, which
+// no other binary path makes redundant.
+bool probe_propagate(ProbeState *state, int head)
+{
+    Formula *formula = state->occ.formula;
+    int binaryHead = head, longHead = head;
+    while (longHead < state->trailSize)
+    {
+        bool binary = binaryHead < state->trailSize;
+        int lit = state->trail[binary ? binaryHead++ : longHead++];
+        GArray *list = occ_live(&state->occ, lit ^ 1);
+        guint len = list->len;
+        for (guint k = 0; k < len; k++)
+        {
+            // Indexed access: a resolvent with -lit is appended to this list
+            Clause *clause = &formula->clauses[g_array_index(list, int, k)];
+            if ((clause->size == 2) != binary)
+                continue;
+            probing.steps += clause->size;
+            int unit = -1, open = 0;
+            bool satisfied = false;
+            for (int i = 0; i < clause->size && !satisfied; i++)
             {
-                if (assignments[other.var] == -1)
+                int code = literal_code(clause->literals[i]);
+                int value = state->value[code >> 1];
+                if (value < 0)
                 {
-                    assignments[other.var] = other.neg ? 0 : 1;
-                    push_assignment(stack, other.var);
-
-                    int index = watchlist_index(other, formula->numVars);
-                    GArray *wlist = wtable->watch_lists[index];
-                    for (int i = 0; i < wlist->len; i++)
-                    {
-                        int indexc = g_array_index(wlist, int, i);
-                        Clause *clause = &formula->clauses[indexc];
-                        if (!clause->satisfied)
-                        {
-                            clause->satisfied = true;
-                            push_clause_satisfy(stack, indexc);
-                        }
-                    }
-
-                    Literal *lit_copy = malloc(sizeof(Literal));
-                    lit_copy->var = other.var;
-                    lit_copy->neg = other.neg;
-                    g_queue_push_tail(queue, lit_copy);
+                    open += code != unit;
+                    unit = code;
                 }
                 else
                 {
-                    g_queue_free_full(queue, free);
-                    return false;
+                    satisfied = value != (code & 1);
                 }
             }
+            if (satisfied || open > 1)
+                continue;
+            if (open == 0)
+                return false;
+
+            int parent = lit;
+            if (clause->size > 2 && state->level > 0)
+            {
+                parent = probe_dominator(state, clause, unit);
+                int binary[2] = {code_to_int(parent ^ 1), code_to_int(unit)};
+                occ_reserve(&state->occ, formula->numVars, formula->numClauses + 1);
+                add_clause(formula, &state->occ.capacity, binary, 2);
+                occ_add_clause(&state->occ, formula->numClauses - 1);
+                proof_add_clause(binary, 2);
+                probing.hyper_binary++;
+            }
+            probe_assign(state, unit, parent);
         }
     }
-
-    g_queue_free_full(queue, free);
     return true;
 }
 
-bool pure_literal_elimination(Formula *formula, int *assignments, UndoStack *stack)
+// Assume code and propagate, then undo back to level 0. False if it failed;
+// the literals it implied are not probed again in this round.
+bool probe_literal(ProbeState *state, int code, int round)
 {
-    bool *positive_units = calloc(formula->numVars + 1, sizeof(bool));
-    bool *negative_units = calloc(formula->numVars + 1, sizeof(bool));
+    probing.probed++;
+    state->level = 1;
+    probe_assign(state, code, -1);
+    bool consistent = probe_propagate(state, state->fixed);
+    for (int i = state->fixed; i < state->trailSize; i++)
+    {
+        if (consistent)
+            state->reached[state->trail[i]] = round;
+        state->value[state->trail[i] >> 1] = -1;
+    }
+    state->trailSize = state->fixed;
+    state->level = 0;
+    return consistent;
+}
 
-    for (int i = 0; i < formula->numClauses; i++)
+// Remove each binary clause (a | b) when b is reachable from -a over the other
+// binary clauses, found by a depth-first search. Reachability between literals
+// stays the same, so later probes imply the same literals.
+void transitive_reduction(ProbeState *state, GArray *stack)
+{
+    OccurrenceLists *occ = &state->occ;
+    Formula *formula = occ->formula;
+    for (int index = 0; index < formula->numClauses && probing.steps < probing.budget; index++)
     {
-        if (formula->clauses[i].satisfied)
-        {
+        Clause *clause = &formula->clauses[index];
+        if (occ->removed[index] || clause->size != 2)
+            continue;
+        int a = literal_code(clause->literals[0]), b = literal_code(clause->literals[1]);
+        if (a >> 1 == b >> 1 || state->value[a >> 1] >= 0 || state->value[b >> 1] >= 0)
             continue;
-        }
 
-        for (int j = 0; j < formula->clauses[i].size; j++)
+        int start = a ^ 1;
+        occ->epoch++;
+        occ->stamp[start] = occ->epoch;
+        g_array_set_size(stack, 0);
+        g_array_append_val(stack, start);
+        bool found = false;
+        while (stack->len > 0 && !found)
         {
-            if (assignments[formula->clauses[i].literals[j].var] != -1)
+            int lit = g_array_index(stack, int, stack->len - 1);
+            g_array_set_size(stack, stack->len - 1);
+            GArray *list = occ_live(occ, lit ^ 1);
+            for (guint k = 0; k < list->len && !found; k++)
             {
-                continue; // Skipping already assigned variables
+                int other = g_array_index(list, int, k);
+                const Literal *lits = formula->clauses[other].literals;
+                probing.steps++;
+                if (other == index || formula->clauses[other].size != 2)
+                    continue;
+                int next = literal_code(lits[0]) == (lit ^ 1) ? literal_code(lits[1]) : literal_code(lits[0]);
+                if (occ->stamp[next] == occ->epoch)
+                    continue;
+                occ->stamp[next] = occ->epoch;
+                found = next == b;
+                g_array_append_val(stack, next);
             }
+        }
 
-            if (formula->clauses[i].literals[j].neg)
-            {
-                negative_units[formula->clauses[i].literals[j].var] = true;
-            }
-            else
-            {
-                positive_units[formula->clauses[i].literals[j].var] = true;
-            }
+        if (found)
+        {
+            proof_delete_clause(clause);
+            occ_remove_clause(occ, index);
+            probing.reduced++;
         }
     }
+}
 
-    bool *lit_purity = calloc(formula->numVars + 1, sizeof(bool));
-    for (int var = 1; var <= formula->numVars; var++)
+// Probe in rounds until a round finds no failed literal and adds no resolvent,
+// or the budget runs out. Only literals that imply something over a binary
+// clause are probed, those without incoming binary implications (roots) first.
+// Failed literals become unit clauses; if their propagation conflicts, the
+// formula is unsatisfiable and the units make the search see it at once.
+void probe_failed_literals(Formula *formula)
+{
+    int numVars = formula->numVars, numCodes = 2 * numVars + 2;
+    ProbeState state;
+    state.occ = occ_init(formula);
+    state.value = malloc(sizeof(int) * (numVars + 1));
+    state.parent = malloc(sizeof(int) * (numVars + 1));
+    state.depth = malloc(sizeof(int) * (numVars + 1));
+    state.trail = malloc(sizeof(int) * (numVars + 1));
+    state.reached = calloc(numCodes, sizeof(int));
+    state.trailSize = 0;
+    state.fixed = 0;
+    state.level = 0;
+    for (int var = 0; var <= numVars; var++)
     {
-        if (assignments[var] != -1)
-        {
-            continue; // Skipping already assigned variables
-        }
+        state.value[var] = -1;
+    }
 
-        if (positive_units[var] && !negative_units[var])
-        {
-            lit_purity[var] = true;
-            assignments[var] = 1;
-            push_assignment(stack, var);
-        }
-        else if (!positive_units[var] && negative_units[var])
-        {
-            lit_purity[var] = true;
-            assignments[var] = 0;
-            push_assignment(stack, var);
-        }
+    bool consistent = true;
+    for (int i = 0; i < formula->numClauses && consistent; i++)
+    {
+        if (formula->clauses[i].size != 1)
+            continue;
+        int code = literal_code(formula->clauses[i].literals[0]);
+        if (state.value[code >> 1] < 0)
+            probe_assign(&state, code, -1);
+        else
+            consistent = state.value[code >> 1] != (code & 1);
     }
+    consistent = consistent && probe_propagate(&state, 0);
+    state.fixed = state.trailSize;
 
-    for (int i = 0; i < formula->numClauses; i++)
+    int *binaries = malloc(sizeof(int) * numCodes);
+    int *candidates = malloc(sizeof(int) * numCodes);
+    GArray *stack = g_array_new(FALSE, FALSE, sizeof(int));
+    bool progress = true;
+    while (consistent && progress && probing.steps < probing.budget)
     {
-        bool satisfied = false;
+        int round = ++probing.rounds;
+        int failedBefore = probing.failed, resolventsBefore = probing.hyper_binary;
 
-        for (int j = 0; j < formula->clauses[i].size; j++)
+        memset(binaries, 0, sizeof(int) * numCodes);
+        for (int i = 0; i < formula->numClauses; i++)
         {
-            if (lit_purity[formula->clauses[i].literals[j].var])
+            if (!state.occ.removed[i] && formula->clauses[i].size == 2)
             {
-                satisfied = true;
-                break;
+                binaries[literal_code(formula->clauses[i].literals[0])]++;
+                binaries[literal_code(formula->clauses[i].literals[1])]++;
+            }
+        }
+        int numCandidates = 0;
+        for (int roots = 1; roots >= 0; roots--)
+        {
+            for (int code = 2; code < numCodes; code++)
+            {
+                if (binaries[code ^ 1] > 0 && (binaries[code] == 0) == roots)
+                    candidates[numCandidates++] = code;
             }
         }
 
-        if (satisfied)
+        for (int i = 0; i < numCandidates && consistent && probing.steps < probing.budget; i++)
         {
-            formula->clauses[i].satisfied = true;
-            push_clause_satisfy(stack, i);
+            int code = candidates[i];
+            if (state.value[code >> 1] >= 0 || state.reached[code] == round || probe_literal(&state, code, round))
+                continue;
+
+            int unit = code_to_int(code ^ 1);
+            occ_reserve(&state.occ, numVars, formula->numClauses + 1);
+            add_clause(formula, &state.occ.capacity, &unit, 1);
+            occ_add_clause(&state.occ, formula->numClauses - 1);
+            proof_add_clause(&unit, 1);
+            probing.failed++;
+            probe_assign(&state, code ^ 1, -1);
+            consistent = probe_propagate(&state, state.fixed);
+            state.fixed = state.trailSize;
         }
+
+        if (consistent)
+        {
+            transitive_reduction(&state, stack);
+        }
+        progress = probing.failed > failedBefore || probing.hyper_binary > resolventsBefore;
     }
+    probing.exhausted = probing.steps >= probing.budget;
+
+    g_array_free(stack, TRUE);
+    free(binaries);
+    free(candidates);
+    free(state.value);
+    free(state.parent);
+    free(state.depth);
+    free(state.trail);
+    free(state.reached);
+    occ_finish(&state.occ);
+}
 
-    free(positive_units);
-    free(negative_units);
-    free(lit_purity);
+// Lucky phases
 
+// Every clause has a literal that the constant assignment value satisfies
+bool lucky_constant(const Formula *formula, bool value)
+{
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        const Clause *clause = &formula->clauses[i];
+        bool satisfied = false;
+        for (int j = 0; j < clause->size && !satisfied; j++)
+        {
+            satisfied = clause->literals[j].neg != value;
+        }
+        if (!satisfied)
+            return false;
+    }
     return true;
 }
 
-int pick_unassigned_variable(Formula *formula, int *assignments)
+// Clauses of each literal code in one flat array, start holds numCodes + 1
+// offsets. Built once for the greedy phases.
+typedef struct
 {
-    // Pick first unassigned variable
-    // for (int i = 1; i < formula->numVars; i++)
-    // {
-    //     if (assignments[i] == -1)
-    //     {
-    //         return i;
-    //     }
-    // }
+    int *start;
+    int *clauses;
+    int *value; // Per variable: -1 unassigned, 0 false, 1 true
+    int *trail; // True literal codes in assignment order
+    int trailSize;
+} LuckyState;
+
+void lucky_assign(LuckyState *state, int code)
+{
+    state->value[code >> 1] = !(code & 1);
+    state->trail[state->trailSize++] = code;
+}
 
-    // Pick most often occuring variable
-    for (int i = 0; i < formula->numVars; i++)
+// Propagate the trail from head, false on a conflict
+bool lucky_propagate(LuckyState *state, const Formula *formula, int head)
+{
+    while (head < state->trailSize)
     {
-        if (var_sort[i] == 0)
-        {
-            return -1;
-        }
-
-        if (assignments[var_sort[i]] == -1)
+        int falseCode = state->trail[head++] ^ 1;
+        for (int k = state->start[falseCode]; k < state->start[falseCode + 1]; k++)
         {
-            return var_sort[i];
+            const Clause *clause = &formula->clauses[state->clauses[k]];
+            int unit = -1, open = 0;
+            bool satisfied = false;
+            for (int i = 0; i < clause->size && !satisfied; i++)
+            {
+                int code = literal_code(clause->literals[i]);
+                int value = state->value[code >> 1];
+                if (value < 0)
+                {
+                    open += code != unit;
+                    unit = code;
+                }
+                else
+                {
+                    satisfied = value != (code & 1);
+                }
+            }
+            if (satisfied || open > 1)
+                continue;
+            if (open == 0)
+                return false;
+            lucky_assign(state, unit);
         }
     }
-
-    return -1;
+    return true;
 }
 
-Formula *parse_formula(const char *filename)
+// Unit clauses first, then every unassigned variable set to phase in variable
+// order, forwards or backwards, each followed by propagation. No backtracking:
+// the first conflict ends the attempt.
+bool lucky_greedy(LuckyState *state, const Formula *formula, bool forward, bool phase)
 {
-    FILE *file = fopen(filename, "r");
-    if (!file)
+    int numVars = formula->numVars;
+    for (int var = 1; var <= numVars; var++)
     {
-        return NULL;
+        state->value[var] = -1;
     }
+    state->trailSize = 0;
 
-    int numVars = 0, numClauses = 0;
-    char *line = NULL;
-    size_t len = 0;
-
-    while (getline(&line, &len, file) != -1)
+    for (int i = 0; i < formula->numClauses; i++)
     {
-        if (line[0] == 'p')
-        {
-            sscanf(line, "p cnf %d %d", &numVars, &numClauses);
-            break;
-        }
+        const Clause *clause = &formula->clauses[i];
+        if (clause->size == 0)
+            return false;
+        if (clause->size != 1)
+            continue;
+        int code = literal_code(clause->literals[0]);
+        if (state->value[code >> 1] < 0)
+            lucky_assign(state, code);
+        else if (state->value[code >> 1] == (code & 1))
+            return false;
     }
+    if (!lucky_propagate(state, formula, 0))
+        return false;
 
-    Formula *formula = (Formula *)malloc(sizeof(Formula));
-    formula->numVars = numVars;
-    formula->numClauses = numClauses;
-    formula->clauses = (Clause *)malloc(sizeof(Clause) * numClauses);
-
-    printf("| Vars: %d | Clauses: %d |\n", numVars, numClauses);
-
-    int clauseIndex = 0;
-    while (getline(&line, &len, file) != -1 && clauseIndex < numClauses)
+    for (int i = 0; i < numVars; i++)
     {
-        if (line[0] == 'c' || line[0] == 'p' || strlen(line) < 2)
+        int var = forward ? i + 1 : numVars - i;
+        if (state->value[var] >= 0)
             continue;
+        int head = state->trailSize;
+        lucky_assign(state, 2 * var + !phase);
+        if (!lucky_propagate(state, formula, head))
+            return false;
+    }
+    return true;
+}
 
-        int lit;
-        int clauseSize = 0;
-        int capacity = 4; // Starting capacity that can be doubled if more space is needed
-        Literal *literals = (Literal *)malloc(sizeof(Literal) * capacity);
-
-        char *token = strtok(line, " \t\n");
-        while (token != NULL)
+// A complete model written to assignments and the undo stack with every clause
+// marked satisfied, the state a successful search ends in
+void install_model(Formula *formula, int *assignments, UndoStack *stack, const int *model)
+{
+    for (int var = 1; var <= formula->numVars; var++)
+    {
+        assignments[var] = model[var];
+        push_assignment(stack, var);
+    }
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (!formula->clauses[i].satisfied)
         {
-            lit = atoi(token);
-            if (lit == 0)
-                break;
+            formula->clauses[i].satisfied = true;
+            push_clause_satisfy(stack, i);
+        }
+    }
+}
 
-            if (clauseSize >= capacity)
+// Try the lucky phases in order and install the first one that satisfies the
+// formula
+bool lucky_phases(Formula *formula, int *assignments, UndoStack *stack)
+{
+    int numVars = formula->numVars, numCodes = 2 * numVars + 2;
+    int *model = malloc(sizeof(int) * (numVars + 1));
+    lucky.phase = -1;
+    for (int phase = LUCKY_ALL_FALSE; phase <= LUCKY_ALL_TRUE && lucky.phase < 0; phase++)
+    {
+        lucky.tried++;
+        if (lucky_constant(formula, phase == LUCKY_ALL_TRUE))
+        {
+            lucky.phase = phase;
+            for (int var = 1; var <= numVars; var++)
             {
-                capacity *= 2;
-                literals = (Literal *)realloc(literals, sizeof(Literal) * capacity);
+                model[var] = phase == LUCKY_ALL_TRUE;
             }
+        }
+    }
 
-            literals[clauseSize].var = abs(lit);
-            literals[clauseSize].neg = lit < 0;
-            clauseSize++;
+    if (lucky.phase < 0)
+    {
+        LuckyState state;
+        state.start = calloc(numCodes + 1, sizeof(int));
+        for (int i = 0; i < formula->numClauses; i++)
+        {
+            for (int j = 0; j < formula->clauses[i].size; j++)
+            {
+                state.start[literal_code(formula->clauses[i].literals[j]) + 1]++;
+            }
+        }
+        for (int code = 0; code < numCodes; code++)
+        {
+            state.start[code + 1] += state.start[code];
+        }
+        int *fill = malloc(sizeof(int) * numCodes);
+        memcpy(fill, state.start, sizeof(int) * numCodes);
+        state.clauses = malloc(sizeof(int) * (state.start[numCodes] + 1));
+        for (int i = 0; i < formula->numClauses; i++)
+        {
+            for (int j = 0; j < formula->clauses[i].size; j++)
+            {
+                state.clauses[fill[literal_code(formula->clauses[i].literals[j])]++] = i;
+            }
+        }
+        free(fill);
+        state.value = model;
+        state.trail = malloc(sizeof(int) * (numVars + 1));
 
-            token = strtok(NULL, " \t\n");
+        for (int phase = LUCKY_FORWARD_FALSE; phase < NUM_LUCKY_PHASES && lucky.phase < 0; phase++)
+        {
+            lucky.tried++;
+            bool forward = phase == LUCKY_FORWARD_FALSE || phase == LUCKY_FORWARD_TRUE;
+            bool value = phase == LUCKY_FORWARD_TRUE || phase == LUCKY_BACKWARD_TRUE;
+            if (lucky_greedy(&state, formula, forward, value))
+                lucky.phase = phase;
         }
 
-        formula->clauses[clauseIndex].size = clauseSize;
-        formula->clauses[clauseIndex].literals = literals;
-        formula->clauses[clauseIndex].satisfied = false;
-        clauseIndex++;
+        free(state.start);
+        free(state.clauses);
+        free(state.trail);
     }
 
-    // Resize if the file does not contain up the the correct amount of clauses.
-    if (clauseIndex < numClauses)
+    if (lucky.phase >= 0)
     {
-        Clause *resize_clauses = realloc(formula->clauses, sizeof(Clause) * clauseIndex);
-        formula->numClauses = clauseIndex;
+        install_model(formula, assignments, stack, model);
     }
-
-    free(line);
-    fclose(file);
-
-    return formula;
+    free(model);
+    return lucky.phase >= 0;
 }
 
-// Undo Stack Push Functions
+// Bit-parallel simulation
 
-void push_assignment(UndoStack *stack, int var)
-{
-    UndoEntry *e = malloc(sizeof(UndoEntry));
-    e->type = ASSIGNMENT;
-    e->var = var;
-    stack->head = g_slist_prepend(stack->head, e);
-}
+#define SIM_LANES 64
 
-void push_clause_satisfy(UndoStack *stack, int index)
+// Clauses of each variable in one flat array, start holds numVars + 2 offsets.
+// Bit i of value and assigned belongs to lane i.
+typedef struct
 {
-    UndoEntry *e = malloc(sizeof(UndoEntry));
-    e->type = CLAUSE_SATISFY;
-    e->index = index;
-    stack->head = g_slist_prepend(stack->head, e);
+    int *start;
+    int *clauses;
+    uint64_t *value;
+    uint64_t *assigned; // Lanes where the variable has a value, while propagating
+    int *queue;         // Variables whose clauses are visited next, circular
+    bool *queued;
+    int head;
+    int count;
+    Rng rng;
+} SimState;
+
+void sim_enqueue(SimState *state, int var, int capacity)
+{
+    if (!state->queued[var])
+    {
+        state->queue[(state->head + state->count++) % capacity] = var;
+        state->queued[var] = true;
+    }
 }
 
-void watchtable_add(WatchTable *wtable, int index, int value, UndoStack *stack)
+// Lanes in which every literal of the clause is false
+static inline uint64_t sim_falsified(const Clause *clause, const uint64_t *value)
 {
-    GArray *arr = wtable->watch_lists[index];
-    g_array_append_val(arr, value);
-
-    UndoEntry *e = malloc(sizeof(UndoEntry));
-    e->type = WATCHLIST_ADD;
-    e->index = index;
-    e->var = value;
-    stack->head = g_slist_prepend(stack->head, e);
+    uint64_t satisfied = 0;
+    for (int i = 0; i < clause->size; i++)
+    {
+        Literal lit = clause->literals[i];
+        satisfied |= lit.neg ? ~value[lit.var] : value[lit.var];
+    }
+    simulation.steps += clause->size;
+    return ~satisfied;
 }
 
-void watchtable_remove(WatchTable *wtable, int index, int value, UndoStack *stack)
+// Unit propagation in every lane at once. A clause is unit in the lanes where
+// exactly one literal is open and none is true; its open literal is set there.
+// Lanes with a conflict keep going, the flips deal with them later.
+void sim_propagate(SimState *state, const Formula *formula)
 {
-    GArray *arr = wtable->watch_lists[index];
-    for (int i = 0; i < arr->len; i++)
+    int capacity = formula->numVars + 1;
+    while (state->count > 0 && !simulation.exhausted)
     {
-        if (g_array_index(arr, int, i) == value)
+        int var = state->queue[state->head];
+        state->head = (state->head + 1) % capacity;
+        state->count--;
+        state->queued[var] = false;
+
+        for (int k = state->start[var]; k < state->start[var + 1]; k++)
         {
-            g_array_remove_index(arr, i);
-            break;
+            const Clause *clause = &formula->clauses[state->clauses[k]];
+            uint64_t satisfied = 0, open = 0, open2 = 0;
+            for (int i = 0; i < clause->size; i++)
+            {
+                Literal lit = clause->literals[i];
+                uint64_t unset = ~state->assigned[lit.var];
+                uint64_t value = lit.neg ? ~state->value[lit.var] : state->value[lit.var];
+                satisfied |= value & ~unset;
+                open2 |= open & unset;
+                open |= unset;
+            }
+            simulation.steps += clause->size;
+
+            uint64_t unit = open & ~open2 & ~satisfied;
+            for (int i = 0; unit && i < clause->size; i++)
+            {
+                Literal lit = clause->literals[i];
+                uint64_t lanes = unit & ~state->assigned[lit.var];
+                if (lanes)
+                {
+                    state->assigned[lit.var] |= lanes;
+                    state->value[lit.var] = lit.neg ? state->value[lit.var] & ~lanes : state->value[lit.var] | lanes;
+                    sim_enqueue(state, lit.var, capacity);
+                }
+            }
         }
+        simulation.exhausted = simulation.steps >= simulation.budget;
     }
-
-    UndoEntry *e = malloc(sizeof(UndoEntry));
-    e->type = WATCHLIST_REMOVE;
-    e->index = index;
-    e->var = value;
-    stack->head = g_slist_prepend(stack->head, e);
 }
 
-void undo_to_checkpoint(UndoStack *stack, GSList *checkpoint, Formula *formula, int *assignments, WatchTable *wtable)
+// Lanes in which flipping var falsifies a clause: those where it gives the only
+// true literal of one of its clauses
+uint64_t sim_breaks(SimState *state, const Formula *formula, int var)
 {
-    while (stack->head != checkpoint)
+    uint64_t breaks = 0;
+    for (int k = state->start[var]; k < state->start[var + 1]; k++)
     {
-        UndoEntry *e = stack->head->data;
-        if (e->type == ASSIGNMENT)
+        const Clause *clause = &formula->clauses[state->clauses[k]];
+        uint64_t mine = 0, one = 0, two = 0;
+        for (int i = 0; i < clause->size; i++)
         {
-            assignments[e->var] = -1;
+            Literal lit = clause->literals[i];
+            uint64_t value = lit.neg ? ~state->value[lit.var] : state->value[lit.var];
+            two |= one & value;
+            one |= value;
+            mine |= lit.var == var ? value : 0;
         }
-        else if (e->type == WATCHLIST_ADD)
+        breaks |= mine & one & ~two;
+        simulation.steps += clause->size;
+    }
+    return breaks;
+}
+
+// Every falsified clause is flipped true in the lanes that falsify it. A lane
+// flips a variable that breaks no other clause if the clause has one (WalkSAT's
+// freebie), otherwise one of its variables at random.
+void sim_flip_round(SimState *state, const Formula *formula)
+{
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        const Clause *clause = &formula->clauses[i];
+        uint64_t falsified = sim_falsified(clause, state->value);
+        int offset = falsified ? (int)rng_below(&state->rng, clause->size) : 0;
+        for (int j = 0; falsified && j < clause->size; j++)
         {
-            GArray *arr = wtable->watch_lists[e->index];
-            for (int i = 0; i < arr->len; i++)
-            {
-                if (g_array_index(arr, int, i) == e->var)
-                {
-                    g_array_remove_index(arr, i);
-                    break;
-                }
-            }
+            int var = clause->literals[(offset + j) % clause->size].var;
+            uint64_t lanes = falsified & ~sim_breaks(state, formula, var);
+            state->value[var] ^= lanes;
+            falsified &= ~lanes;
+            simulation.flips += __builtin_popcountll(lanes);
         }
-        else if (e->type == WATCHLIST_REMOVE)
+        for (int j = 0; falsified && j < clause->size; j++)
         {
-            GArray *arr = wtable->watch_lists[e->index];
-            g_array_append_val(arr, e->var);
+            int var = clause->literals[(offset + j) % clause->size].var;
+            uint64_t lanes = j + 1 < clause->size ? falsified & rng_next(&state->rng) : falsified;
+            state->value[var] ^= lanes;
+            falsified &= ~lanes;
+            simulation.flips += __builtin_popcountll(lanes);
         }
-        else if (e->type == CLAUSE_SATISFY)
+    }
+}
+
+// Lane falsifying the fewest clauses, their number in unsat
+int sim_best_lane(SimState *state, const Formula *formula, int *unsat)
+{
+    int counts[SIM_LANES] = {0};
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        for (uint64_t lanes = sim_falsified(&formula->clauses[i], state->value); lanes; lanes &= lanes - 1)
         {
-            formula->clauses[e->index].satisfied = false;
+            counts[__builtin_ctzll(lanes)]++;
         }
+    }
 
-        GSList *next = stack->head->next;
-        free(e);
-        g_slist_free_1(stack->head);
-        stack->head = next;
+    int best = 0;
+    for (int lane = 1; lane < SIM_LANES; lane++)
+    {
+        if (counts[lane] < counts[best])
+            best = lane;
     }
+    *unsat = counts[best];
+    return best;
 }
 
-// WatchTable Init and Free functions
-
-WatchTable *init_empty_watch_table(Formula *formula)
+void sim_save_phases(SimState *state, int numVars, int lane)
 {
-    WatchTable *wtable = (WatchTable *)malloc(sizeof(WatchTable));
-    wtable->numVars = formula->numVars * 2 + 1;
-    wtable->watch_lists = (GArray **)calloc(wtable->numVars, sizeof(GArray *));
-
-    for (int i = 0; i < wtable->numVars; i++)
+    for (int var = 1; var <= numVars; var++)
     {
-        wtable->watch_lists[i] = g_array_new(FALSE, FALSE, sizeof(int));
+        decision_phase[var] = (state->value[var] >> lane) & 1;
     }
-
-    return wtable;
 }
 
-void free_watchtable(WatchTable *wtable)
+// Random values in decision order, each followed by propagation in all lanes,
+// then flip rounds until a lane satisfies the formula or the budget is spent.
+// A satisfying lane is installed as the model; otherwise the best lane becomes
+// the phase of every variable.
+bool simulate_assignments(Formula *formula, int *assignments, UndoStack *stack)
 {
-    if (!wtable)
-        return;
+    int numVars = formula->numVars;
+    simulation.steps = 0;
+    simulation.exhausted = false;
+    simulation.rounds = 0;
+    simulation.flips = 0;
+    simulation.initial_unsat = -1;
+    simulation.best_unsat = -1;
+    free(decision_phase);
+    decision_phase = NULL;
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (formula->clauses[i].size == 0)
+            return false;
+    }
 
-    for (int i = 0; i < wtable->numVars; i++)
+    SimState state;
+    state.start = calloc(numVars + 2, sizeof(int));
+    for (int i = 0; i < formula->numClauses; i++)
     {
-        if (wtable->watch_lists[i])
+        for (int j = 0; j < formula->clauses[i].size; j++)
         {
-            g_array_free(wtable->watch_lists[i], TRUE);
+            state.start[formula->clauses[i].literals[j].var + 1]++;
+        }
+    }
+    for (int var = 0; var <= numVars; var++)
+    {
+        state.start[var + 1] += state.start[var];
+    }
+    int *fill = malloc(sizeof(int) * (numVars + 1));
+    memcpy(fill, state.start, sizeof(int) * (numVars + 1));
+    state.clauses = malloc(sizeof(int) * (state.start[numVars + 1] + 1));
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        for (int j = 0; j < formula->clauses[i].size; j++)
+        {
+            state.clauses[fill[formula->clauses[i].literals[j].var]++] = i;
         }
     }
+    free(fill);
+    state.value = calloc(numVars + 1, sizeof(uint64_t));
+    state.assigned = calloc(numVars + 1, sizeof(uint64_t));
+    state.queue = malloc(sizeof(int) * (numVars + 1));
+    state.queued = calloc(numVars + 1, sizeof(bool));
+    state.head = 0;
+    state.count = 0;
+    rng_seed(&state.rng, simulation.seed);
 
-    g_free(wtable->watch_lists);
+    for (int i = 0; i < formula->numClauses; i++)
+    {
+        if (formula->clauses[i].size == 1)
+            sim_enqueue(&state, formula->clauses[i].literals[0].var, numVars + 1);
+    }
+    sim_propagate(&state, formula);
+    for (int i = 0; i < 2 * numVars; i++)
+    {
+        // The decision order first, then any variable it leaves out
+        int var = i < numVars ? (var_sort ? var_sort[i] : i + 1) : i - numVars + 1;
+        if (var == 0 || state.assigned[var] == ~0ull)
+            continue;
+        uint64_t lanes = ~state.assigned[var];
+        state.value[var] = (state.value[var] & ~lanes) | (rng_next(&state.rng) & lanes);
+        state.assigned[var] = ~0ull;
+        sim_enqueue(&state, var, numVars + 1);
+        sim_propagate(&state, formula);
+    }
 
-    g_free(wtable);
+    decision_phase = calloc(numVars + 1, sizeof(unsigned char));
+    int unsat;
+    int lane = sim_best_lane(&state, formula, &unsat);
+    sim_save_phases(&state, numVars, lane);
+    simulation.initial_unsat = unsat;
+    simulation.best_unsat = unsat;
+    while (simulation.best_unsat > 0 && simulation.steps < simulation.budget)
+    {
+        simulation.rounds++;
+        sim_flip_round(&state, formula);
+        lane = sim_best_lane(&state, formula, &unsat);
+        if (unsat < simulation.best_unsat)
+        {
+            simulation.best_unsat = unsat;
+            sim_save_phases(&state, numVars, lane);
+        }
+    }
+    simulation.exhausted = simulation.best_unsat > 0;
+
+    if (simulation.best_unsat == 0)
+    {
+        int *model = malloc(sizeof(int) * (numVars + 1));
+        for (int var = 1; var <= numVars; var++)
+        {
+            model[var] = decision_phase[var];
+        }
+        install_model(formula, assignments, stack, model);
+        free(model);
+    }
+
+    free(state.start);
+    free(state.clauses);
+    free(state.value);
+    free(state.assigned);
+    free(state.queue);
+    free(state.queued);
+    return simulation.best_unsat == 0;
 }
 
-// Formula Free function
+// Batch mode
 
-void free_formula(Formula *formula)
+// Instances of at most 64 variables in one word each: bit v - 1 of an
+// assignment is variable v and a clause is the masks of its positive and
+// negative variables. Propagation is a few word operations per clause, and a
+// search level copies two words instead of pushing undo entries.
+#define WORD_VARS 64
+
+typedef struct
 {
-    for (int i = 0; i < formula->numClauses; i++)
+    uint64_t pos;
+    uint64_t neg;
+} WordClause;
+
+typedef struct
+{
+    int numVars;
+    int numClauses;
+    int capacity;
+    WordClause *clauses;
+    bool empty;            // Has an empty clause
+    int numOrder;
+    int order[WORD_VARS];  // Variables that occur, most occurrences first
+    unsigned long long decisions;
+} WordFormula;
+
+void word_reset(WordFormula *formula)
+{
+    formula->numVars = 0;
+    formula->numClauses = 0;
+    formula->empty = false;
+    formula->numOrder = 0;
+    formula->decisions = 0;
+}
+
+// DIMACS literals of one clause, false if a variable does not fit in a word.
+// Tautologies are dropped, repeated literals merge in the masks.
+bool word_add_clause(WordFormula *formula, const int *lits, int size)
+{
+    WordClause clause = {0, 0};
+    for (int i = 0; i < size; i++)
     {
-        free(formula->clauses[i].literals);
+        int var = abs(lits[i]);
+        if (var > WORD_VARS)
+            return false;
+        formula->numVars = var > formula->numVars ? var : formula->numVars;
+        if (lits[i] > 0)
+            clause.pos |= 1ull << (var - 1);
+        else
+            clause.neg |= 1ull << (var - 1);
     }
-    free(formula->clauses);
-    free(formula);
-}
 
-// Function to satisfy clauses after an assignment occurs
+    formula->empty |= size == 0;
+    if (size == 0 || (clause.pos & clause.neg))
+        return true;
+    if (formula->numClauses == formula->capacity)
+    {
+        formula->capacity = formula->capacity ? 2 * formula->capacity : 64;
+        formula->clauses = realloc(formula->clauses, sizeof(WordClause) * formula->capacity);
+    }
+    formula->clauses[formula->numClauses++] = clause;
+    return true;
+}
 
-void satisfy_clauses_after_assignment(Formula *formula, int *assignments, UndoStack *stack)
+// Decision order as the occurrence heuristic: most occurrences first, ties by index
+void word_order(WordFormula *formula)
 {
+    int count[WORD_VARS + 1] = {0};
     for (int i = 0; i < formula->numClauses; i++)
     {
-        Clause *clause = &formula->clauses[i];
-
-        if (clause->satisfied)
+        for (uint64_t vars = formula->clauses[i].pos | formula->clauses[i].neg; vars; vars &= vars - 1)
         {
+            count[__builtin_ctzll(vars) + 1]++;
+        }
+    }
+
+    formula->numOrder = 0;
+    for (int var = 1; var <= formula->numVars; var++)
+    {
+        if (count[var] == 0)
             continue;
+        int k = formula->numOrder++;
+        while (k > 0 && count[formula->order[k - 1]] < count[var])
+        {
+            formula->order[k] = formula->order[k - 1];
+            k--;
         }
+        formula->order[k] = var;
+    }
+}
 
-        bool satisfied = false;
-        for (int j = 0; j < clause->size; j++)
+// Unit propagation to fixpoint: -1 on a conflict, 1 once every clause is
+// satisfied, 0 otherwise. value only has bits of assigned variables.
+int word_propagate(const WordFormula *formula, uint64_t *assigned, uint64_t *value)
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        bool satisfied = true;
+        for (int i = 0; i < formula->numClauses; i++)
         {
-            Literal lit = clause->literals[j];
-            int a = assignments[lit.var];
-            if ((a == 0 && lit.neg) || (a == 1 && !lit.neg))
+            const WordClause *clause = &formula->clauses[i];
+            if ((clause->pos & *value) | (clause->neg & *assigned & ~*value))
+                continue;
+            uint64_t open = (clause->pos | clause->neg) & ~*assigned;
+            if (open == 0)
+                return -1;
+            satisfied = false;
+            if ((open & (open - 1)) == 0)
             {
-                clause->satisfied = true;
-                push_clause_satisfy(stack, i);
-                break;
+                *assigned |= open;
+                *value |= open & clause->pos;
+                changed = true;
             }
         }
+        if (!changed && satisfied)
+            return 1;
     }
+    return 0;
 }
 
-// Superset helper methods
-
-gint lit_key(Literal *lit)
+// DPLL over the word state, false branch first as in dpll. The decision limit
+// applies per instance, the wall-clock and CPU limits to the whole batch.
+DPLLReturnType word_dpll(WordFormula *formula, uint64_t assigned, uint64_t value, uint64_t *model)
 {
-    return lit->neg ? -lit->var : lit->var;
+    int state = word_propagate(formula, &assigned, &value);
+    if (state != 0)
+    {
+        *model = value;
+        return state > 0 ? SAT : UNSAT;
+    }
+    if ((limits.decisions && formula->decisions >= limits.decisions) || limit_exceeded())
+    {
+        return TIMEOUT;
+    }
+
+    // An open clause has an unassigned variable, and every such variable is in the order
+    int var = 0;
+    for (int i = 0; i < formula->numOrder && var == 0; i++)
+    {
+        if (!(assigned & (1ull << (formula->order[i] - 1))))
+            var = formula->order[i];
+    }
+    uint64_t bit = 1ull << (var - 1);
+
+    formula->decisions++;
+    DPLLReturnType result = word_dpll(formula, assigned | bit, value, model);
+    if (result != UNSAT)
+    {
+        return result;
+    }
+    formula->decisions++;
+    return word_dpll(formula, assigned | bit, value | bit, model);
 }
 
-gboolean clause_subset(Clause *a, Clause *b)
+bool word_satisfies(const WordFormula *formula, uint64_t model)
 {
-    GHashTable *setB = g_hash_table_new(g_int_hash, g_int_equal);
-    for (int i = 0; i < b->size; i++)
+    for (int i = 0; i < formula->numClauses; i++)
     {
-        gint *k = g_new(gint, 1);
-        *k = lit_key(&b->literals[i]);
-        g_hash_table_add(setB, k);
+        if (!((formula->clauses[i].pos & model) | (formula->clauses[i].neg & ~model)))
+            return false;
     }
+    return !formula->empty;
+}
 
-    gboolean is_subset = true;
-    for (int i = 0; i < a->size; i++)
+DPLLReturnType word_solve(WordFormula *formula, uint64_t *model)
+{
+    word_order(formula);
+    if (formula->empty)
     {
-        gint key = lit_key(&a->literals[i]);
-        if (!g_hash_table_contains(setB, &key))
-        {
-            is_subset = false;
-            break;
-        }
+        return UNSAT;
     }
-
-    g_hash_table_destroy(setB);
-    return is_subset;
+    return word_dpll(formula, 0, 0, model);
 }
 
-void remove_supersets(Formula *formula)
+// A DIMACS file into formula, false if it cannot be read or has more than 64
+// variables. Clauses may span lines, and a clause left open at the end is dropped.
+bool word_read(const char *path, WordFormula *formula)
 {
-    gboolean *remove_marked = g_new0(gboolean, formula->numClauses);
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        return false;
+    }
 
-    for (int i = 0; i < formula->numClauses; i++)
+    word_reset(formula);
+    char *line = NULL;
+    size_t len = 0;
+    int lits[WORD_VARS * 2 + 1], size = 0;
+    bool ok = true;
+    while (ok && getline(&line, &len, file) != -1)
     {
-        if (remove_marked[i])
+        if (line[0] == '%')
+            break; // SATLIB files end with "%" and a lone 0
+        if (line[0] == 'c')
+            continue;
+        if (line[0] == 'p')
         {
+            int numVars = 0;
+            ok = sscanf(line, "p cnf %d", &numVars) == 1 && numVars <= WORD_VARS;
+            formula->numVars = numVars > formula->numVars ? numVars : formula->numVars;
             continue;
         }
 
-        for (int j = 0; j < formula->numClauses; j++)
+        char *cursor = line, *end;
+        for (long lit = strtol(cursor, &end, 10); end != cursor; lit = strtol(cursor, &end, 10))
         {
-            if (i == j || remove_marked[j])
+            cursor = end;
+            if (lit == 0)
             {
-                continue;
+                ok = word_add_clause(formula, lits, size);
+                size = 0;
             }
-
-            Clause *clausei = &formula->clauses[i];
-            Clause *clausej = &formula->clauses[j];
-
-            if (clausei->size >= clausej->size && clause_subset(clausej, clausei))
+            else if (size < WORD_VARS * 2 + 1 && labs(lit) <= WORD_VARS)
             {
-                remove_marked[i] = true;
+                lits[size++] = (int)lit;
+            }
+            else
+            {
+                ok = false;
                 break;
             }
         }
     }
+    free(line);
+    fclose(file);
+    return ok;
+}
 
-    int counter = 0;
-    for (int i = 0; i < formula->numClauses; i++)
+void print_word_model(uint64_t model, int numVars)
+{
+    printf("v");
+    for (int var = 1; var <= numVars; var++)
     {
-        if (!remove_marked[i])
+        printf(" %d", (model >> (var - 1)) & 1 ? var : -var);
+    }
+    printf(" 0\n");
+}
+
+// One line per instance: path, result and decisions. Models are verified before
+// SAT is reported. A wall-clock or CPU limit ends the batch at the instance that
+// reaches it. Exit code 0 if every instance was solved, 1 if one was skipped or
+// hit a limit, 130/143 when interrupted.
+int run_batch(char **paths, int count, bool show_model)
+{
+    double start = wall_seconds();
+    WordFormula formula = {0, 0, 0, NULL, false, 0, {0}, 0};
+    int solved[3] = {0}, skipped = 0, done = 0;
+    unsigned long long decisions = 0;
+    for (int i = 0; i < count && !interrupt_signal && limit_reached == LIMIT_NONE; i++)
+    {
+        if (!word_read(paths[i], &formula))
         {
-            formula->clauses[counter] = formula->clauses[i];
-            counter++;
+            printf("%s SKIPPED (unreadable or more than %d variables)\n", paths[i], WORD_VARS);
+            skipped++;
+            done++;
+            continue;
         }
-        else
+
+        // An interrupted instance is left out, as if the batch had stopped before it
+        uint64_t model = 0;
+        DPLLReturnType result = word_solve(&formula, &model);
+        if (result == TIMEOUT && interrupt_signal)
+            break;
+        done++;
+        if (result == SAT && !word_satisfies(&formula, model))
         {
-            free(formula->clauses[i].literals);
+            printf("%s ERROR (model does not satisfy the formula)\n", paths[i]);
+            skipped++;
+            continue;
+        }
+        decisions += formula.decisions;
+        solved[result]++;
+        printf("%s %s %llu\n", paths[i], result == SAT ? "SAT" : result == UNSAT ? "UNSAT" : "TIMEOUT",
+               formula.decisions);
+        if (result == SAT && show_model)
+        {
+            print_word_model(model, formula.numVars);
         }
     }
+    free(formula.clauses);
 
-    formula->numClauses = counter;
-    formula->clauses = realloc(formula->clauses, sizeof(Clause) * counter);
-    g_free(remove_marked);
+    double elapsed = wall_seconds() - start;
+    printf("Batch: %d instances (%d SAT, %d UNSAT, %d TIMEOUT, %d skipped), %llu decisions in %.3f s (%.0f instances/s)\n",
+           done, solved[SAT], solved[UNSAT], solved[TIMEOUT], skipped, decisions, elapsed,
+           elapsed > 0 ? done / elapsed : 0.0);
+    if (interrupt_signal)
+    {
+        printf("Result: INTERRUPTED (%s) after %d of %d instances\n", interrupt_signal == SIGINT ? "SIGINT" : "SIGTERM",
+               done, count);
+        return 128 + interrupt_signal;
+    }
+    if (limit_reached == LIMIT_WALL || limit_reached == LIMIT_CPU)
+    {
+        printf("Result: TIMEOUT (%s limit) after %d of %d instances\n",
+               limit_reached == LIMIT_WALL ? "wall-clock time" : "CPU time", done, count);
+    }
+    return skipped || solved[TIMEOUT] ? 1 : 0;
 }
@@ -0,0 +1,329 @@
+// Trains the configuration selector behind sat_solver --auto-config. Reads CSVs
+// written by sat_benchmark whose config labels are preset names (--config), keeps
+// the PAR-2 score of every preset per instance, extracts the instance features
+// and writes both as the k-NN model. The best preset of an instance is the first
+// one within timing noise of the fastest, so that presets that behave the same on
+// it do not split it by chance. A leave-one-out run then compares the selector
+// against the best single preset and the per-instance oracle.
+#define SAT_SOLVER_NO_MAIN
+#include "sat_solver.c"
+#include <fcntl.h>
+
+// Differences below both thresholds are treated as noise, as in sat_benchmark
+#define NOISE_SECONDS 0.05
+#define NOISE_FRACTION 0.10
+
+bool within_noise(double par2, double fastest)
+{
+    double delta = par2 - fastest;
+    return delta < NOISE_SECONDS || delta < NOISE_FRACTION * fastest;
+}
+
+typedef struct
+{
+    char *instance;
+    double par2[NUM_PRESETS];
+    bool seen[NUM_PRESETS];
+    bool solved; // By at least one preset
+    int best;
+    double features[NUM_FEATURES];
+} TrainingInstance;
+
+// Column index of a header field, -1 if missing
+int csv_column(const char *header, const char *name)
+{
+    char *copy = strdup(header);
+    char *save = NULL;
+    int column = 0, found = -1;
+    for (char *tok = strtok_r(copy, ",\n\r", &save); tok != NULL; tok = strtok_r(NULL, ",\n\r", &save), column++)
+    {
+        if (strcmp(tok, name) == 0)
+        {
+            found = column;
+            break;
+        }
+    }
+    free(copy);
+    return found;
+}
+
+TrainingInstance *find_instance(GPtrArray *instances, GHashTable *index, const char *name)
+{
+    TrainingInstance *inst = g_hash_table_lookup(index, name);
+    if (!inst)
+    {
+        inst = calloc(1, sizeof(TrainingInstance));
+        inst->instance = strdup(name);
+        g_hash_table_insert(index, inst->instance, inst);
+        g_ptr_array_add(instances, inst);
+    }
+    return inst;
+}
+
+// Add the runs of one benchmark CSV; rows whose config is not a preset are skipped
+bool load_runs(const char *path, GPtrArray *instances, GHashTable *index)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        perror(path);
+        return false;
+    }
+
+    char *line = NULL;
+    size_t len = 0;
+    if (getline(&line, &len, file) == -1)
+    {
+        free(line);
+        fclose(file);
+        return false;
+    }
+
+    int col_instance = csv_column(line, "instance");
+    int col_config = csv_column(line, "config");
+    int col_result = csv_column(line, "result");
+    int col_par2 = csv_column(line, "par2");
+    if (col_instance < 0 || col_config < 0 || col_result < 0 || col_par2 < 0)
+    {
+        fprintf(stderr, "%s lacks instance/config/result/par2 columns\n", path);
+        free(line);
+        fclose(file);
+        return false;
+    }
+
+    while (getline(&line, &len, file) != -1)
+    {
+        const char *instance = NULL, *config = NULL, *result = NULL;
+        double par2 = -1.0;
+        int column = 0;
+        char *save = NULL;
+        for (char *tok = strtok_r(line, ",\n\r", &save); tok != NULL; tok = strtok_r(NULL, ",\n\r", &save), column++)
+        {
+            if (column == col_instance)
+                instance = tok;
+            else if (column == col_config)
+                config = tok;
+            else if (column == col_result)
+                result = tok;
+            else if (column == col_par2)
+                par2 = atof(tok);
+        }
+
+        int preset = config ? find_preset(config) : -1;
+        if (!instance || !result || preset < 0 || par2 < 0)
+            continue;
+
+        TrainingInstance *inst = find_instance(instances, index, instance);
+        inst->par2[preset] = par2;
+        inst->seen[preset] = true;
+        inst->solved |= strcmp(result, "SAT") == 0 || strcmp(result, "UNSAT") == 0;
+    }
+
+    free(line);
+    fclose(file);
+    return true;
+}
+
+// Features of one instance, with parse_formula's header line silenced
+bool instance_features(const char *path, double *features)
+{
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+    Formula *formula = parse_formula(path);
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(devnull);
+    close(saved_stdout);
+
+    if (!formula)
+    {
+        return false;
+    }
+    extract_features(formula, features);
+    free_formula(formula);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *output = "results/selector_model.csv";
+
+    static struct option long_options[] = {
+        {"output", required_argument, 0, 'o'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf("Usage: %s [-o model.csv] <benchmark.csv>...\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        printf("Usage: %s [-o model.csv] <benchmark.csv>...\n", argv[0]);
+        return 1;
+    }
+
+    GPtrArray *instances = g_ptr_array_new();
+    GHashTable *index = g_hash_table_new(g_str_hash, g_str_equal);
+    for (int i = optind; i < argc; i++)
+    {
+        if (!load_runs(argv[i], instances, index))
+        {
+            return 1;
+        }
+    }
+
+    // Training rows: solved instances with their best preset and features
+    SelectorModel model = {0, NULL, NULL, NULL, {0.0}, {0.0}};
+    model.preset = malloc(sizeof(int) * (instances->len + 1));
+    model.features = malloc(sizeof(double) * (instances->len + 1) * NUM_FEATURES);
+    model.cost = malloc(sizeof(double) * (instances->len + 1) * NUM_PRESETS);
+    TrainingInstance **rows = malloc(sizeof(TrainingInstance *) * (instances->len + 1));
+    int best_count[NUM_PRESETS] = {0};
+    for (guint i = 0; i < instances->len; i++)
+    {
+        TrainingInstance *inst = g_ptr_array_index(instances, i);
+        int fastest = -1;
+        for (int p = 0; p < NUM_PRESETS; p++)
+        {
+            if (inst->seen[p] && (fastest < 0 || inst->par2[p] < inst->par2[fastest]))
+            {
+                fastest = p;
+            }
+        }
+        inst->best = fastest;
+        for (int p = 0; p < fastest; p++)
+        {
+            if (inst->seen[p] && within_noise(inst->par2[p], inst->par2[fastest]))
+            {
+                inst->best = p;
+                break;
+            }
+        }
+        if (!inst->solved || inst->best < 0)
+        {
+            continue;
+        }
+        if (!instance_features(inst->instance, inst->features))
+        {
+            fprintf(stderr, "Cannot parse %s, skipped\n", inst->instance);
+            continue;
+        }
+
+        memcpy(&model.features[model.count * NUM_FEATURES], inst->features, sizeof(double) * NUM_FEATURES);
+        for (int p = 0; p < NUM_PRESETS; p++)
+        {
+            model.cost[model.count * NUM_PRESETS + p] = inst->seen[p] ? inst->par2[p] : -1.0;
+        }
+        model.preset[model.count] = inst->best;
+        rows[model.count++] = inst;
+        best_count[inst->best]++;
+    }
+
+    FILE *out = fopen(output, "w");
+    if (!out)
+    {
+        perror(output);
+        return 1;
+    }
+    fprintf(out, "config");
+    for (int f = 0; f < NUM_FEATURES; f++)
+    {
+        fprintf(out, ",%s", feature_names[f]);
+    }
+    for (int p = 0; p < NUM_PRESETS; p++)
+    {
+        fprintf(out, ",par2_%s", presets[p].name);
+    }
+    fprintf(out, "\n");
+    for (int r = 0; r < model.count; r++)
+    {
+        fprintf(out, "%s", presets[model.preset[r]].name);
+        for (int f = 0; f < NUM_FEATURES; f++)
+        {
+            fprintf(out, ",%.6f", model.features[r * NUM_FEATURES + f]);
+        }
+        for (int p = 0; p < NUM_PRESETS; p++)
+        {
+            fprintf(out, ",%.6f", model.cost[r * NUM_PRESETS + p]);
+        }
+        fprintf(out, "\n");
+    }
+    fclose(out);
+
+    printf("Training: %d instances -> %s\nBest preset:", model.count, output);
+    for (int p = 0; p < NUM_PRESETS; p++)
+    {
+        printf(" %s %d%s", presets[p].name, best_count[p], p + 1 < NUM_PRESETS ? "," : "\n");
+    }
+
+    // Leave-one-out on the instances that every preset was run on
+    selector_standardize(&model);
+    int evaluated = 0, hits = 0;
+    double selected = 0.0, oracle = 0.0, single[NUM_PRESETS] = {0.0};
+    for (int r = 0; r < model.count; r++)
+    {
+        bool complete = true;
+        for (int p = 0; p < NUM_PRESETS; p++)
+        {
+            complete &= rows[r]->seen[p];
+        }
+        int chosen = select_preset(&model, rows[r]->features, r, true);
+        if (!complete || chosen < 0)
+        {
+            continue;
+        }
+
+        evaluated++;
+        hits += within_noise(rows[r]->par2[chosen], rows[r]->par2[rows[r]->best]);
+        selected += rows[r]->par2[chosen];
+        oracle += rows[r]->par2[rows[r]->best];
+        for (int p = 0; p < NUM_PRESETS; p++)
+        {
+            single[p] += rows[r]->par2[p];
+        }
+    }
+
+    if (evaluated > 0)
+    {
+        int best_single = 0;
+        for (int p = 1; p < NUM_PRESETS; p++)
+        {
+            if (single[p] < single[best_single])
+                best_single = p;
+        }
+        printf("Leave-one-out: %d/%d within noise of the best preset | PAR-2 selector %.3f, best single (%s) %.3f, oracle %.3f\n", hits,
+               evaluated, selected / evaluated, presets[best_single].name, single[best_single] / evaluated,
+               oracle / evaluated);
+    }
+    else
+    {
+        printf("Leave-one-out: no instance was run with every preset\n");
+    }
+
+    free(rows);
+    free(model.preset);
+    free(model.features);
+    free(model.cost);
+    for (guint i = 0; i < instances->len; i++)
+    {
+        TrainingInstance *inst = g_ptr_array_index(instances, i);
+        free(inst->instance);
+        free(inst);
+    }
+    g_hash_table_destroy(index);
+    g_ptr_array_free(instances, TRUE);
+    return 0;
+}
@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <glib.h>
+
+// Converts a binary search trace written by sat_solver --trace into folded
+// stacks (for flamegraph.pl / speedscope) or Chrome trace JSON (chrome://tracing,
+// Perfetto). Stack frames are the decision variables on the current DPLL path.
+
+// Must match TraceEventType, TraceRecord and TRACE_MAGIC in sat_solver.c
+typedef enum
+{
+    TRACE_DECISION,
+    TRACE_PROPAGATE,
+    TRACE_CONFLICT,
+    TRACE_BACKTRACK
+} TraceEventType;
+
+typedef struct
+{
+    uint64_t time_ns;
+    int32_t value;
+    uint32_t type_depth;
+} TraceRecord;
+
+#define TRACE_MAGIC "SATTRC01"
+#define TRACE_VERSION 1
+
+typedef struct
+{
+    int *vars;
+    int depth;
+    int capacity;
+} PathStack;
+
+void path_set(PathStack *path, int depth, int var)
+{
+    if (depth >= path->capacity)
+    {
+        path->capacity = (depth + 1) * 2;
+        path->vars = realloc(path->vars, sizeof(int) * path->capacity);
+    }
+    path->vars[depth] = var;
+    path->depth = depth + 1;
+}
+
+GString *path_string(const PathStack *path)
+{
+    GString *str = g_string_new("search");
+    for (int i = 0; i < path->depth; i++)
+    {
+        g_string_append_printf(str, ";x%d", path->vars[i]);
+    }
+    return str;
+}
+
+bool read_header(FILE *in)
+{
+    char magic[8];
+    uint32_t header[2];
+    if (fread(magic, 1, 8, in) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0)
+    {
+        fprintf(stderr, "Not a sat_solver trace file\n");
+        return false;
+    }
+    if (fread(header, sizeof(uint32_t), 2, in) != 2 || header[0] != TRACE_VERSION || header[1] != sizeof(TraceRecord))
+    {
+        fprintf(stderr, "Unsupported trace version or record size\n");
+        return false;
+    }
+    return true;
+}
+
+// Time between consecutive events is charged to the path that was open
+void convert_folded(FILE *in, FILE *out)
+{
+    GHashTable *weights = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    PathStack path = {NULL, 0, 0};
+    TraceRecord record;
+    uint64_t last_time = 0;
+
+    while (fread(&record, sizeof(record), 1, in) == 1)
+    {
+        uint64_t delta = record.time_ns - last_time;
+        last_time = record.time_ns;
+
+        if (delta > 0)
+        {
+            GString *key = path_string(&path);
+            uint64_t *weight = g_hash_table_lookup(weights, key->str);
+            if (weight)
+            {
+                *weight += delta;
+                g_string_free(key, TRUE);
+            }
+            else
+            {
+                weight = g_new(uint64_t, 1);
+                *weight = delta;
+                g_hash_table_insert(weights, g_string_free(key, FALSE), weight);
+            }
+        }
+
+        int type = record.type_depth & 0xff;
+        int depth = (int)(record.type_depth >> 8);
+        if (type == TRACE_DECISION)
+        {
+            path_set(&path, depth, abs(record.value));
+        }
+        else if (type == TRACE_BACKTRACK && depth < path.depth)
+        {
+            path.depth = depth;
+        }
+    }
+
+    // Weights in microseconds, the usual unit for folded stacks
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, weights);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        uint64_t us = *(uint64_t *)value / 1000;
+        if (us > 0)
+        {
+            fprintf(out, "%s %llu\n", (char *)key, (unsigned long long)us);
+        }
+    }
+
+    g_hash_table_destroy(weights);
+    free(path.vars);
+}
+
+void convert_chrome(FILE *in, FILE *out)
+{
+    TraceRecord record;
+    PathStack path = {NULL, 0, 0};
+    uint64_t last_time = 0;
+    bool first = true;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    while (fread(&record, sizeof(record), 1, in) == 1)
+    {
+        double ts = record.time_ns / 1000.0;
+        int type = record.type_depth & 0xff;
+        int depth = (int)(record.type_depth >> 8);
+        last_time = record.time_ns;
+
+        if (type == TRACE_DECISION)
+        {
+            // A decision replacing an open one at the same depth closes it first
+            while (path.depth > depth)
+            {
+                fprintf(out, "%s{\"ph\":\"E\",\"pid\":1,\"tid\":1,\"ts\":%.3f}", first ? "" : ",\n", ts);
+                first = false;
+                path.depth--;
+            }
+            fprintf(out, "%s{\"name\":\"x%d=%d\",\"ph\":\"B\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"depth\":%d}}",
+                    first ? "" : ",\n", abs(record.value), record.value > 0, ts, depth);
+            path_set(&path, depth, abs(record.value));
+        }
+        else if (type == TRACE_BACKTRACK)
+        {
+            while (path.depth > depth)
+            {
+                fprintf(out, "%s{\"ph\":\"E\",\"pid\":1,\"tid\":1,\"ts\":%.3f}", first ? "" : ",\n", ts);
+                path.depth--;
+            }
+        }
+        else if (type == TRACE_CONFLICT)
+        {
+            fprintf(out, "%s{\"name\":\"conflict\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"depth\":%d}}",
+                    first ? "" : ",\n", ts, depth);
+        }
+        else if (type == TRACE_PROPAGATE)
+        {
+            fprintf(out, "%s{\"name\":\"propagations\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"count\":%d}}",
+                    first ? "" : ",\n", ts, record.value);
+        }
+        first = false;
+    }
+
+    // Close whatever was still open when the search stopped
+    while (path.depth > 0)
+    {
+        fprintf(out, "%s{\"ph\":\"E\",\"pid\":1,\"tid\":1,\"ts\":%.3f}", first ? "" : ",\n", last_time / 1000.0);
+        first = false;
+        path.depth--;
+    }
+
+    fprintf(out, "\n]}\n");
+    free(path.vars);
+}
+
+int main(int argc, char *argv[])
+{
+    bool chrome = false;
+    const char *output = NULL;
+
+    static struct option long_options[] = {
+        {"folded", no_argument, 0, 'f'},
+        {"chrome", no_argument, 0, 'c'},
+        {"output", required_argument, 0, 'o'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "fco:h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            chrome = false;
+            break;
+        case 'c':
+            chrome = true;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf("Usage: %s [--folded|--chrome] [-o output] <trace.bin>\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind != argc - 1)
+    {
+        printf("Usage: %s [--folded|--chrome] [-o output] <trace.bin>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[optind], "rb");
+    if (!in)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if (!read_header(in))
+    {
+        fclose(in);
+        return 1;
+    }
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out)
+    {
+        perror(output);
+        fclose(in);
+        return 1;
+    }
+
+    if (chrome)
+    {
+        convert_chrome(in, out);
+    }
+    else
+    {
+        convert_folded(in, out);
+    }
+
+    fclose(in);
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    return 0;
+}
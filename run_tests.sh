@@ -1,12 +1,13 @@
 #!/bin/bash
+# Runs every .cnf file in a directory (default: tests/) through the benchmark
+# harness. Extra options are passed on, e.g.
+#   ./run_tests.sh -t 60 -o results/run.csv -b results/baseline.csv tests
 
-for file in ./files/*; do
-    echo "Running: $file"
-    ./main "$file"
-    
-    status=$?
-    if [ $status -ne 0 ]; then
-        echo "Error (exit code $status) with file: $file"
-        read -p "Press Enter to continue to the next file..."  # optional pause
-    fi
-done
+set -e
+make --no-print-directory all benchmark
+
+if [ $# -eq 0 ]; then
+    set -- tests
+fi
+
+exec ./sat_benchmark "$@"